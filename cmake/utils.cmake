@@ -79,6 +79,28 @@ endfunction(add_gtest_app)
 
 ##############################################################################
 
+## Register a gtest app with ctest: the whole suite once, then the tests matching realtimeFilter
+## once per DSP tier of the target CPU, selected with TBE_DSP_TIER. A macro, enable_testing() has to
+## run in the scope of the directory.
+macro(add_gtest_ctest appName realtimeFilter)
+  if(NOT IOS)
+    enable_testing()
+    add_test(NAME ${appName} COMMAND ${appName})
+
+    if(CMAKE_SYSTEM_PROCESSOR MATCHES "^(arm|aarch64|ARM64)")
+      set(TBE_TEST_TIERS scalar neon)
+    else()
+      set(TBE_TEST_TIERS scalar sse avx)
+    endif()
+    foreach(tier ${TBE_TEST_TIERS})
+      add_test(NAME ${appName}-realtime-${tier} COMMAND ${appName} --gtest_filter=${realtimeFilter})
+      set_tests_properties(${appName}-realtime-${tier} PROPERTIES ENVIRONMENT TBE_DSP_TIER=${tier})
+    endforeach()
+  endif()
+endmacro(add_gtest_ctest)
+
+##############################################################################
+
 ## Include the dsp library in a cmake project. 
 macro(include_dsp repoRootPath)
   if(NOT TARGET dsp)
@@ -114,8 +136,17 @@ macro(setup_msvc_static_crt_option)
   option(MSVC_STATIC_CRT "Enable MT builds on Windows" ON)
 endmacro()
 
+## Exposes BENCHMARKS_ENABLED as a CMake option. Benchmark apps are never built for iOS or Android
+macro(setup_benchmark_option)
+  option(BENCHMARKS_ENABLED "Build the benchmark apps" ON)
+  if (IOS OR ANDROID)
+    set(BENCHMARKS_ENABLED OFF)
+  endif()
+endmacro()
+
 ## Setup default options
 macro(setup_default_options)
   setup_msvc_static_crt_option()
   setup_gtest_option()
+  setup_benchmark_option()
 endmacro()
@@ -0,0 +1,46 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <malloc.h>
+#endif
+
+namespace TBE {
+/// Alignment of the buffers handed to the DSP kernels. One cache line, which also covers the
+/// widest register (AVX-512)
+static const size_t kCacheLineSize = 64;
+
+/// \return value rounded up to a multiple of alignment, which must be a power of two
+inline size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/// Allocate memory aligned to kCacheLineSize. Must be released with alignedFree()
+/// \param size Size in bytes
+/// \return The memory or nullptr if the allocation failed
+inline void* alignedMalloc(size_t size) {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+  return _aligned_malloc(size, kCacheLineSize);
+#else
+  void* ptr = nullptr;
+  return posix_memalign(&ptr, kCacheLineSize, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+inline void alignedFree(void* ptr) {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+} // namespace TBE
@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "AlignedMemory.hh"
+
+namespace TBE {
+/// A bump allocator over one contiguous block, used to lay out a renderer (its FIR taps, delay
+/// lines and scratch buffers) next to each other instead of spreading it across the heap.
+/// Allocations are aligned to kCacheLineSize and are never freed individually: reset() releases
+/// all of them at once, after which the arena can be reused for a new instance. Typical use:
+///
+///   Arena arena(AmbiSphericalConvolution::arenaSize(maxBufferSize, irs));
+///   AmbiSphericalConvolution renderer(maxBufferSize, irs, arena);
+///
+/// Not thread safe. Allocating is only meant for construction time, never for the audio thread.
+class Arena {
+ public:
+  /// Allocate and own a block of capacity bytes
+  explicit Arena(size_t capacity)
+      : base_(static_cast<char*>(alignedMalloc(capacity))), capacity_(capacity), owned_(true) {
+    assert(base_ || capacity == 0);
+  }
+
+  /// Hand out memory from a block owned by the caller, e.g. a static buffer
+  /// \param memory The block, aligned to kCacheLineSize. Must outlive the arena and its users
+  /// \param capacity Size of the block in bytes
+  Arena(void* memory, size_t capacity)
+      : base_(static_cast<char*>(memory)), capacity_(capacity), owned_(false) {
+    assert(reinterpret_cast<uintptr_t>(memory) % kCacheLineSize == 0);
+  }
+
+  ~Arena() {
+    if (owned_) {
+      alignedFree(base_);
+    }
+  }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /// Allocate uninitialised, kCacheLineSize aligned storage for count objects of type T
+  /// \return The storage, or nullptr (and an assert) if the arena is too small
+  template <typename T>
+  T* allocate(size_t count) {
+    const size_t size = sizeOf<T>(count);
+    if (size > capacity_ - used_) {
+      assert(false && "Arena is too small, see the arenaSize() functions");
+      return nullptr;
+    }
+    T* ptr = reinterpret_cast<T*>(base_ + used_);
+    used_ += size;
+    return ptr;
+  }
+
+  /// Release every allocation so the arena can be reused. The objects placed in it must have been
+  /// destroyed already.
+  void reset() {
+    used_ = 0;
+  }
+
+  size_t getCapacity() const {
+    return capacity_;
+  }
+
+  size_t getUsed() const {
+    return used_;
+  }
+
+  /// \return True if ptr points into the block of this arena
+  bool contains(const void* ptr) const {
+    const char* p = static_cast<const char*>(ptr);
+    return p >= base_ && p < base_ + capacity_;
+  }
+
+  /// \return The number of arena bytes taken by count objects of type T
+  template <typename T>
+  static size_t sizeOf(size_t count) {
+    return alignUp(count * sizeof(T), kCacheLineSize);
+  }
+
+ private:
+  char* base_{nullptr};
+  size_t capacity_{0};
+  size_t used_{0};
+  bool owned_{false};
+};
+} // namespace TBE
@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2018-present, Facebook, Inc.
+
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <vector>
+#include "AlignedMemory.hh"
+#include "Arena.hh"
+#include "AudioBufferList.hh"
+
+namespace TBE {
+/// A wait-free single-producer/single-consumer ring of preallocated AudioBufferList blocks, to hand
+/// audio from a decoding thread to the audio callback without locks. Blocks are never copied: the
+/// producer fills a block in place and publishes it, the consumer reads it in place and hands it
+/// back.
+///
+///   // Producer                                 // Consumer (audio thread)
+///   AudioBufferList* block = q.acquireWrite();   AudioBufferList* block = q.acquireRead();
+///   if (block) {                                 if (block) {
+///     decodeInto(*block);                          render(*block);
+///     q.commitWrite();                             q.releaseRead();
+///   }                                            }
+///
+/// Each side may hold at most one block at a time. All blocks are laid out in one arena when the
+/// queue is built, nothing is allocated afterwards.
+class AudioBlockQueue {
+ public:
+  /// \param numBlocks Number of blocks in the ring, i.e. how far the producer can run ahead
+  /// \param numSamplesPerChannel Samples per channel of each block
+  /// \param numChannels Channels of each block
+  AudioBlockQueue(size_t numBlocks, int32_t numSamplesPerChannel, int32_t numChannels)
+      : arena_(numBlocks * AudioBufferList::arenaSize(numSamplesPerChannel, numChannels)) {
+    assert(numBlocks > 0);
+    blocks_.reserve(numBlocks);
+    for (size_t i = 0; i < numBlocks; ++i) {
+      blocks_.emplace_back(new AudioBufferList(numSamplesPerChannel, numChannels, arena_));
+    }
+  }
+
+  AudioBlockQueue(const AudioBlockQueue&) = delete;
+  AudioBlockQueue& operator=(const AudioBlockQueue&) = delete;
+
+  /// Producer only. The block keeps whatever it held when it was last consumed
+  /// \return The next free block, or nullptr if the ring is full
+  AudioBufferList* acquireWrite() {
+    const size_t write = writeCount_.load(std::memory_order_relaxed);
+    if (write - readCount_.load(std::memory_order_acquire) == blocks_.size()) {
+      return nullptr;
+    }
+    return blocks_[write % blocks_.size()].get();
+  }
+
+  /// Producer only. Publish the block returned by the last acquireWrite()
+  void commitWrite() {
+    const size_t write = writeCount_.load(std::memory_order_relaxed);
+    assert(write - readCount_.load(std::memory_order_acquire) < blocks_.size());
+    writeCount_.store(write + 1, std::memory_order_release);
+  }
+
+  /// Consumer only
+  /// \return The oldest published block, or nullptr if the ring is empty
+  AudioBufferList* acquireRead() {
+    const size_t read = readCount_.load(std::memory_order_relaxed);
+    if (writeCount_.load(std::memory_order_acquire) == read) {
+      return nullptr;
+    }
+    return blocks_[read % blocks_.size()].get();
+  }
+
+  /// Consumer only. Hand the block returned by the last acquireRead() back to the producer
+  void releaseRead() {
+    const size_t read = readCount_.load(std::memory_order_relaxed);
+    assert(writeCount_.load(std::memory_order_acquire) != read);
+    readCount_.store(read + 1, std::memory_order_release);
+  }
+
+  /// \return The number of published blocks. Neither side gets an exact count: a lower bound on
+  /// the consumer side, as the producer may have published more since, and an upper bound on the
+  /// producer side, as the consumer may have released more since
+  size_t getNumReadable() const {
+    return writeCount_.load(std::memory_order_acquire) -
+        readCount_.load(std::memory_order_acquire);
+  }
+
+  size_t getNumBlocks() const {
+    return blocks_.size();
+  }
+
+ private:
+  Arena arena_;
+  std::vector<AudioBufferList::UPtr> blocks_;
+
+  // Free running counts, the slot is count % numBlocks. Each is written by one side only and they
+  // sit on their own cache lines so the two threads don't invalidate each other's line on every
+  // block.
+  alignas(kCacheLineSize) std::atomic<size_t> writeCount_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> readCount_{0};
+};
+} // namespace TBE
@@ -11,13 +11,20 @@ LICENSE file in the root directory of this source tree.
 #include <cassert>
 #include <cmath>
 #include <memory>
+#include "../src/AlignedMemory.hh"
+#include "../src/Arena.hh"
+#include "../src/AudioBufferView.hh"
 #include "../src/DSP.hh"
+#include "../src/MemoryFootprint.hh"
 
 namespace TBE {
 class AudioBufferList {
  public:
   using UPtr = std::unique_ptr<AudioBufferList>;
 
+  /// Allocates all channels in one block aligned to kCacheLineSize, each channel starting
+  /// getChannelStride() samples after the previous one. The channel pointer table lives at the
+  /// start of the same block.
   AudioBufferList(int32_t numSamplesPerChannel, int32_t numChannels)
       : numSamplesPerChannel_(numSamplesPerChannel),
         numChannels_(numChannels),
@@ -28,12 +35,23 @@ class AudioBufferList {
     // Can't have 0 samples!
     assert(numSamplesPerChannel_ > 0);
 
-    buffer_ = new float*[numChannels_];
+    storage_ = alignedMalloc(arenaSize(numSamplesPerChannel_, numChannels_));
+    assert(storage_);
+    layout();
+  }
 
-    for (int i = 0; i < numChannels_; ++i) {
-      buffer_[i] = new float[numSamplesPerChannel_];
-      memset(buffer_[i], 0, numSamplesPerChannel_ * sizeof(float));
-    }
+  /// Same layout as above but the block is taken from an arena, which must outlive the list
+  AudioBufferList(int32_t numSamplesPerChannel, int32_t numChannels, Arena& arena)
+      : numSamplesPerChannel_(numSamplesPerChannel),
+        numChannels_(numChannels),
+        ownsBuffer_(false),
+        buffer_(nullptr) {
+    assert(numChannels_ > 0);
+    assert(numSamplesPerChannel_ > 0);
+
+    storage_ = arena.allocate<char>(arenaSize(numSamplesPerChannel_, numChannels_));
+    assert(storage_);
+    layout();
   }
 
   explicit AudioBufferList(
@@ -47,7 +65,12 @@ class AudioBufferList {
         buffer_(otherBuffers) {}
 
   ~AudioBufferList() {
-    if (ownsBuffer_) {
+    if (storage_) {
+      if (ownsBuffer_) {
+        alignedFree(storage_);
+      }
+      buffer_ = nullptr;
+    } else if (ownsBuffer_) {
       for (int i = 0; i < numChannels_; ++i) {
         delete[] buffer_[i];
       }
@@ -70,7 +93,21 @@ class AudioBufferList {
     return const_cast<const float*>(buffer_[channelNum]);
   }
 
+  /// \return A view of all channels and samples, to be sliced with AudioBufferView::channels()
+  /// and AudioBufferView::samples()
+  AudioBufferView view() {
+    return AudioBufferView(buffer_, numChannels_, numSamplesPerChannel_);
+  }
+
+  ConstAudioBufferView view() const {
+    return ConstAudioBufferView(buffer_, numChannels_, numSamplesPerChannel_);
+  }
+
   inline void zero() {
+    if (storage_) {
+      memset(buffer_[0], 0, static_cast<size_t>(numChannels_) * stride_ * sizeof(float));
+      return;
+    }
     for (int i = 0; i < numChannels_; ++i) {
       memset(buffer_[i], 0, numSamplesPerChannel_ * sizeof(float));
     }
@@ -92,13 +129,64 @@ class AudioBufferList {
     return numSamplesPerChannel_;
   }
 
+  /// \return The distance in samples between the starts of two consecutive channels, or 0 if the
+  /// channels were not allocated by this AudioBufferList
+  inline int32_t getChannelStride() const {
+    return stride_;
+  }
+
+  /// \return The number of bytes of the block holding the pointer table and the channels, which
+  /// is also the number of arena bytes used by such a list
+  static size_t arenaSize(int32_t numSamplesPerChannel, int32_t numChannels) {
+    return tableSize(numChannels) +
+        static_cast<size_t>(numChannels) * channelStride(numSamplesPerChannel) * sizeof(float);
+  }
+
+  /// \return The channel stride used for numSamplesPerChannel samples. The channels are padded to
+  /// a whole number of cache lines, plus one line if that is a multiple of 1 KiB: otherwise every
+  /// channel would start on the same cache sets and a many-channel kernel would evict itself.
+  static int32_t channelStride(int32_t numSamplesPerChannel) {
+    const size_t kFloatsPerLine = kCacheLineSize / sizeof(float);
+    const size_t kAliasingPeriod = 1024;
+    size_t stride = alignUp(static_cast<size_t>(numSamplesPerChannel), kFloatsPerLine);
+    if ((stride * sizeof(float)) % kAliasingPeriod == 0) {
+      stride += kFloatsPerLine;
+    }
+    return static_cast<int32_t>(stride);
+  }
+
+  /// \return The bytes of the channels as scratch, as lists are mostly block buffers, and of the
+  /// pointer table and the list itself as state. Buffers passed in without handing over their
+  /// ownership are counted as shared.
+  MemoryFootprint memoryFootprint() const {
+    MemoryFootprint footprint;
+    footprint.state.privateBytes = sizeof(AudioBufferList);
+    MemoryFootprint::Bytes& scratch = footprint.scratch;
+    if (storage_) {
+      footprint.state.privateBytes += tableSize(numChannels_);
+      scratch.privateBytes = static_cast<size_t>(numChannels_) * stride_ * sizeof(float);
+      return footprint;
+    }
+    const size_t tableBytes = static_cast<size_t>(numChannels_) * sizeof(float*);
+    const size_t channelBytes =
+        static_cast<size_t>(numChannels_) * numSamplesPerChannel_ * sizeof(float);
+    if (ownsBuffer_) {
+      footprint.state.privateBytes += tableBytes;
+      scratch.privateBytes = channelBytes;
+    } else {
+      footprint.state.sharedBytes = tableBytes;
+      scratch.sharedBytes = channelBytes;
+    }
+    return footprint;
+  }
+
   void sum(const AudioBufferList& other) {
     assert(&other != this);
     assert(getNumOfChannels() == other.getNumOfChannels());
     assert(getSamplesPerChannel() == other.getSamplesPerChannel());
 
     for (int i = 0; i < getNumOfChannels(); i++) {
-      dsp_.add(
+      dsp_->add(
           getChannelDataToRead(i),
           other.getChannelDataToRead(i),
           getChannelDataToWrite(i),
@@ -111,7 +199,7 @@ class AudioBufferList {
     assert(numOfSamplesToSum <= numSamplesPerChannel_);
 
     for (int i = 0; i < getNumOfChannels(); i++) {
-      dsp_.add(
+      dsp_->add(
           getChannelDataToRead(i),
           other.getChannelDataToRead(i),
           getChannelDataToWrite(i),
@@ -130,7 +218,7 @@ class AudioBufferList {
     assert(numChannels <= getNumOfChannels());
 
     for (int i = 0; i < numChannels; i++) {
-      dsp_.add(
+      dsp_->add(
           getChannelDataToRead(i),
           other.getChannelDataToRead(i + otherChannelOffset),
           getChannelDataToWrite(i),
@@ -150,7 +238,7 @@ class AudioBufferList {
     assert(numChannels <= getNumOfChannels());
 
     for (int i = 0; i < numChannels; i++) {
-      dsp_.add(
+      dsp_->add(
           getChannelDataToRead(i + thisChannelOffset),
           other.getChannelDataToRead(i + otherChannelOffset),
           getChannelDataToWrite(i + thisChannelOffset),
@@ -158,9 +246,17 @@ class AudioBufferList {
     }
   }
 
+  /// Add a view of the same number of channels to the first other.getSamplesPerChannel() samples
+  /// of this list
+  void sum(const ConstAudioBufferView& other) {
+    assert(other.getNumOfChannels() == getNumOfChannels());
+    assert(other.getSamplesPerChannel() <= numSamplesPerChannel_);
+    view().samples(0, other.getSamplesPerChannel()).sum(other);
+  }
+
   void scale(float scalar) {
     for (int32_t c = 0; c < getNumOfChannels(); ++c) {
-      dsp_.multiplyScalar(
+      dsp_->multiplyScalar(
           getChannelDataToWrite(c), scalar, getChannelDataToWrite(c), getSamplesPerChannel());
     }
   }
@@ -173,11 +269,7 @@ class AudioBufferList {
     assert(channel < numChannels_);
     assert(numSamples <= numSamplesPerChannel_);
 
-    float peak = 0.f;
-    for (int i = 0; i < numSamples; ++i) {
-      peak = std::max(peak, std::abs(getChannelDataToRead(channel)[i]));
-    }
-    return peak;
+    return dsp_->peak(getChannelDataToRead(channel), numSamples);
   }
 
   float getRMS(int32_t channel) const {
@@ -187,25 +279,27 @@ class AudioBufferList {
   float getRMS(int32_t channel, int32_t numSamples) const {
     assert(channel < numChannels_);
     assert(numSamples <= numSamplesPerChannel_);
-    float meanSquares{0};
-    auto data = getChannelDataToRead(channel);
-    for (int i = 0; i < numSamples; i++) {
-      meanSquares += (data[i] * data[i]) / numSamples;
+    if (numSamples <= 0) {
+      return 0.f;
     }
-    return sqrtf(meanSquares);
+    const float sumOfSquares = dsp_->sumOfSquares(getChannelDataToRead(channel), numSamples);
+    return sqrtf(sumOfSquares / numSamples);
   }
 
   bool channelIsSilent(int32_t channelIndex, int32_t numSamplesToSearch) const {
     assert(numSamplesToSearch <= numSamplesPerChannel_);
     assert(channelIndex < numChannels_ && channelIndex >= 0);
-    bool result = true;
-    for (int i = 0; i < numSamplesToSearch; ++i) {
-      if (getChannelDataToRead(channelIndex)[i] != 0.f) {
-        result = false;
-        break;
+
+    // Search in blocks so that a non-silent channel exits early
+    const int32_t kSearchBlock = 256;
+    const float* data = getChannelDataToRead(channelIndex);
+    for (int32_t i = 0; i < numSamplesToSearch; i += kSearchBlock) {
+      const int32_t len = std::min(kSearchBlock, numSamplesToSearch - i);
+      if (dsp_->peak(data + i, len) != 0.f) {
+        return false;
       }
     }
-    return result;
+    return true;
   }
 
   bool channelsAreSilent(int32_t numSamplesToSearch) const {
@@ -239,6 +333,33 @@ class AudioBufferList {
 
   float** buffer_;
 
-  FBDSP dsp_;
+  // Single aligned block holding the channel table and the channels, if allocated here. Owned
+  // unless it was taken from an arena
+  void* storage_{nullptr};
+  int32_t stride_{0};
+
+  static size_t tableSize(int32_t numChannels) {
+    return alignUp(numChannels * sizeof(float*), kCacheLineSize);
+  }
+
+  // Point the channel table at the channels in storage_ and clear them
+  void layout() {
+    stride_ = channelStride(numSamplesPerChannel_);
+    buffer_ = static_cast<float**>(storage_);
+    // Checked here as well because the asserts are compiled out of release builds, where the
+    // compiler would otherwise warn about the memset below
+    if (numChannels_ <= 0 || !storage_) {
+      return;
+    }
+    const size_t channelsSize = static_cast<size_t>(numChannels_) * stride_ * sizeof(float);
+    float* channels =
+        reinterpret_cast<float*>(static_cast<char*>(storage_) + tableSize(numChannels_));
+    memset(channels, 0, channelsSize);
+    for (int i = 0; i < numChannels_; ++i) {
+      buffer_[i] = channels + static_cast<size_t>(i) * stride_;
+    }
+  }
+
+  const FBDSP* dsp_{&FBDSP::shared()};
 };
 } // namespace TBE
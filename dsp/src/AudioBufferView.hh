@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2018-present, Facebook, Inc.
+
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include "DSP.hh"
+
+namespace TBE {
+/// A non-owning window on un-interleaved audio: a range of channels of a channel pointer table and
+/// a range of samples in each of them. Slicing only adjusts the table pointer and the sample
+/// offset, so a view can be cut into blocks or routed to a subset of channels without copying or
+/// allocating. The table and the samples must outlive the view.
+///
+///   AudioBufferList bed(1024, 10);
+///   AudioBufferView front = bed.view().channels(0, 3).samples(256, 512);
+///
+/// Use AudioBufferView for samples that are written and ConstAudioBufferView for samples that are
+/// only read. A view of mutable samples converts to a const one.
+template <typename T>
+class BasicAudioBufferView {
+ public:
+  BasicAudioBufferView() = default;
+
+  /// \param channels Table of numChannels channel pointers
+  /// \param numChannels Number of channels in the view
+  /// \param numSamplesPerChannel Number of samples in the view, starting at sampleOffset
+  /// \param sampleOffset First sample of each channel that is part of the view
+  BasicAudioBufferView(
+      T* const* channels,
+      int32_t numChannels,
+      int32_t numSamplesPerChannel,
+      int32_t sampleOffset = 0)
+      : channels_(channels),
+        numChannels_(numChannels),
+        numSamplesPerChannel_(numSamplesPerChannel),
+        sampleOffset_(sampleOffset) {
+    assert(channels_ || numChannels_ == 0);
+    assert(numChannels_ >= 0 && numSamplesPerChannel_ >= 0 && sampleOffset_ >= 0);
+  }
+
+  template <
+      typename U,
+      typename = typename std::enable_if<
+          std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+  BasicAudioBufferView(const BasicAudioBufferView<U>& other)
+      : channels_(other.channels_),
+        numChannels_(other.numChannels_),
+        numSamplesPerChannel_(other.numSamplesPerChannel_),
+        sampleOffset_(other.sampleOffset_) {}
+
+  inline int32_t getNumOfChannels() const {
+    return numChannels_;
+  }
+
+  inline int32_t getSamplesPerChannel() const {
+    return numSamplesPerChannel_;
+  }
+
+  inline bool empty() const {
+    return numChannels_ == 0 || numSamplesPerChannel_ == 0;
+  }
+
+  inline T* getChannelData(int32_t channel) const {
+    // Channel out of bounds!
+    assert(channel >= 0 && channel < numChannels_);
+    return channels_[channel] + sampleOffset_;
+  }
+
+  /// \return A view of numChannels channels starting at firstChannel
+  BasicAudioBufferView channels(int32_t firstChannel, int32_t numChannels) const {
+    assert(firstChannel >= 0 && numChannels >= 0);
+    assert(firstChannel + numChannels <= numChannels_);
+    return BasicAudioBufferView(
+        channels_ + firstChannel, numChannels, numSamplesPerChannel_, sampleOffset_);
+  }
+
+  /// \return A view of numSamples samples starting at firstSample of each channel
+  BasicAudioBufferView samples(int32_t firstSample, int32_t numSamples) const {
+    assert(firstSample >= 0 && numSamples >= 0);
+    assert(firstSample + numSamples <= numSamplesPerChannel_);
+    return BasicAudioBufferView(channels_, numChannels_, numSamples, sampleOffset_ + firstSample);
+  }
+
+  /// Write the start of each channel of the view to pointers, for kernels that take a channel
+  /// table such as FBDSP::matrixMix
+  /// \param pointers Table of at least getNumOfChannels() entries
+  void getChannelPointers(T** pointers) const {
+    for (int32_t c = 0; c < numChannels_; ++c) {
+      pointers[c] = getChannelData(c);
+    }
+  }
+
+  void zero() const {
+    for (int32_t c = 0; c < numChannels_; ++c) {
+      memset(getChannelData(c), 0, numSamplesPerChannel_ * sizeof(float));
+    }
+  }
+
+  /// Copy other into this view. Both views must have the same size
+  void copyFrom(const BasicAudioBufferView<const float>& other) const {
+    assert(other.getNumOfChannels() == numChannels_);
+    assert(other.getSamplesPerChannel() == numSamplesPerChannel_);
+    for (int32_t c = 0; c < numChannels_; ++c) {
+      memmove(getChannelData(c), other.getChannelData(c), numSamplesPerChannel_ * sizeof(float));
+    }
+  }
+
+  /// Add other to this view. Both views must have the same size
+  void sum(const BasicAudioBufferView<const float>& other) const {
+    assert(other.getNumOfChannels() == numChannels_);
+    assert(other.getSamplesPerChannel() == numSamplesPerChannel_);
+    for (int32_t c = 0; c < numChannels_; ++c) {
+      FBDSP::shared().add(
+          getChannelData(c), other.getChannelData(c), getChannelData(c), numSamplesPerChannel_);
+    }
+  }
+
+  void scale(float scalar) const {
+    for (int32_t c = 0; c < numChannels_; ++c) {
+      FBDSP::shared().multiplyScalar(
+          getChannelData(c), scalar, getChannelData(c), numSamplesPerChannel_);
+    }
+  }
+
+  float getPeak(int32_t channel) const {
+    return FBDSP::shared().peak(getChannelData(channel), numSamplesPerChannel_);
+  }
+
+  float getRMS(int32_t channel) const {
+    if (numSamplesPerChannel_ <= 0) {
+      return 0.f;
+    }
+    const float sumOfSquares =
+        FBDSP::shared().sumOfSquares(getChannelData(channel), numSamplesPerChannel_);
+    return sqrtf(sumOfSquares / numSamplesPerChannel_);
+  }
+
+  /// \return True if every sample of the channel is zero, as AudioBufferList::channelIsSilent
+  bool channelIsSilent(int32_t channel) const {
+    return getPeak(channel) == 0.f;
+  }
+
+  bool channelsAreSilent() const {
+    for (int32_t c = 0; c < numChannels_; ++c) {
+      if (!channelIsSilent(c)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  template <typename>
+  friend class BasicAudioBufferView;
+
+  T* const* channels_{nullptr};
+  int32_t numChannels_{0};
+  int32_t numSamplesPerChannel_{0};
+  int32_t sampleOffset_{0};
+};
+
+using AudioBufferView = BasicAudioBufferView<float>;
+using ConstAudioBufferView = BasicAudioBufferView<const float>;
+} // namespace TBE
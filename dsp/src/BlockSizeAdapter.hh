@@ -0,0 +1,129 @@
+/*
+Copyright (c) 2018-present, Facebook, Inc.
+
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "AudioBufferList.hh"
+#include "AudioBufferView.hh"
+
+namespace TBE {
+/// Runs an engine that processes fixed blocks of blockSize samples, such as a block FFT
+/// convolution, behind a host that calls back with any number of samples, possibly a different
+/// number each time. TEngine needs
+///
+///   void process(const ConstAudioBufferView& in, const AudioBufferView& out);
+///
+/// which is always called with exactly blockSize samples, e.g. AmbiSphericalConvolution built with
+/// a maxBufferSize of blockSize.
+///
+/// The input is collected in a FIFO and the engine runs as soon as a block is complete, so the
+/// output is delayed by getLatency() = blockSize - 1 samples, the least possible for arbitrary
+/// callback sizes. If the host size is fixed and a multiple of blockSize the adapter is a
+/// passthrough instead: each callback is cut into blocks that go straight to the engine, with no
+/// copies and no latency.
+template <typename TEngine>
+class BlockSizeAdapter {
+ public:
+  /// \param engine The engine, which must outlive the adapter
+  /// \param numInputs Number of input channels given to the engine
+  /// \param numOutputs Number of output channels written by the engine
+  /// \param blockSize The number of samples the engine processes per call
+  /// \param hostBufferSize The host callback size if it never changes, 0 if it can vary
+  BlockSizeAdapter(
+      TEngine& engine,
+      int32_t numInputs,
+      int32_t numOutputs,
+      int32_t blockSize,
+      int32_t hostBufferSize = 0)
+      : engine_(engine),
+        blockSize_(blockSize),
+        passthrough_(hostBufferSize > 0 && hostBufferSize % blockSize == 0),
+        inputFifo_(blockSize, numInputs),
+        outputBlock_(blockSize, numOutputs) {
+    assert(blockSize > 0);
+    reset();
+  }
+
+  BlockSizeAdapter(const BlockSizeAdapter&) = delete;
+  BlockSizeAdapter& operator=(const BlockSizeAdapter&) = delete;
+
+  /// Process one host callback. Not thread safe
+  /// \param input numInputs channels of any length
+  /// \param output numOutputs channels, as long as input. Must not alias input
+  void process(const ConstAudioBufferView& input, const AudioBufferView& output) {
+    const int32_t numSamples = output.getSamplesPerChannel();
+    assert(input.getNumOfChannels() == inputFifo_.getNumOfChannels());
+    assert(output.getNumOfChannels() == outputBlock_.getNumOfChannels());
+    assert(input.getSamplesPerChannel() >= numSamples);
+
+    if (passthrough_) {
+      // Callbacks must keep the size given to the constructor, or at least stay whole blocks
+      assert(numSamples % blockSize_ == 0);
+      for (int32_t offset = 0; offset < numSamples; offset += blockSize_) {
+        engine_.process(input.samples(offset, blockSize_), output.samples(offset, blockSize_));
+      }
+      return;
+    }
+
+    //
+    // The sample written at fill position i of the input FIFO is output with outputBlock_[i + 1]
+    // of the previous block, and the last sample of a block with the first output of that block
+    // once it has been processed. This keeps the latency at blockSize - 1.
+    //
+    const ConstAudioBufferView fifoIn = static_cast<const AudioBufferList&>(inputFifo_).view();
+    const ConstAudioBufferView blockOut = static_cast<const AudioBufferList&>(outputBlock_).view();
+    int32_t offset = 0;
+    while (offset < numSamples) {
+      const int32_t len = std::min(numSamples - offset, blockSize_ - fill_);
+      inputFifo_.view().samples(fill_, len).copyFrom(input.samples(offset, len));
+
+      if (fill_ + len < blockSize_) {
+        output.samples(offset, len).copyFrom(blockOut.samples(fill_ + 1, len));
+        fill_ += len;
+      } else {
+        output.samples(offset, len - 1).copyFrom(blockOut.samples(fill_ + 1, len - 1));
+        engine_.process(fifoIn, outputBlock_.view());
+        output.samples(offset + len - 1, 1).copyFrom(blockOut.samples(0, 1));
+        fill_ = 0;
+      }
+      offset += len;
+    }
+  }
+
+  /// \return The delay in samples between the input and the output
+  int32_t getLatency() const {
+    return passthrough_ ? 0 : blockSize_ - 1;
+  }
+
+  bool isPassthrough() const {
+    return passthrough_;
+  }
+
+  int32_t getBlockSize() const {
+    return blockSize_;
+  }
+
+  /// Drop the buffered input and output, e.g. after a seek. Does not reset the engine
+  void reset() {
+    inputFifo_.zero();
+    outputBlock_.zero();
+    fill_ = 0;
+  }
+
+ private:
+  TEngine& engine_;
+  const int32_t blockSize_;
+  const bool passthrough_;
+  AudioBufferList inputFifo_;
+  AudioBufferList outputBlock_;
+  // Samples of the next block in inputFifo_
+  int32_t fill_{0};
+};
+} // namespace TBE
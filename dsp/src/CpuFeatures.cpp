@@ -0,0 +1,241 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "CpuFeatures.hh"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if !defined(__ARM_NEON) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define TBE_CPU_X86 1
+#endif
+
+namespace TBE {
+namespace CPU {
+namespace {
+#ifdef TBE_CPU_X86
+void runCpuid(uint32_t eax, uint32_t ecx, uint32_t* abcd) {
+#if defined(_MSC_VER)
+  __cpuidex((int*)abcd, eax, ecx);
+#else
+  uint32_t ebx = 0;
+  uint32_t edx = 0;
+#if defined(__i386__) && defined(__PIC__)
+  /* in case of PIC under 32-bit EBX cannot be clobbered */
+  __asm__("movl %%ebx, %%edi \n\t cpuid \n\t xchgl %%ebx, %%edi"
+          : "=D"(ebx),
+#else
+  __asm__("cpuid"
+          : "+b"(ebx),
+#endif
+            "+a"(eax),
+            "+c"(ecx),
+            "=d"(edx));
+  abcd[0] = eax;
+  abcd[1] = ebx;
+  abcd[2] = ecx;
+  abcd[3] = edx;
+#endif
+}
+
+uint32_t readXcr0() {
+#if defined(_MSC_VER)
+  return (uint32_t)_xgetbv(0); /* min VS2010 SP1 compiler is required */
+#else
+  uint32_t xcr0;
+  __asm__("xgetbv" : "=a"(xcr0) : "c"(0) : "%edx");
+  return xcr0;
+#endif
+}
+
+Features detect() {
+  Features f;
+  uint32_t abcd[4];
+
+  runCpuid(0, 0, abcd);
+  const uint32_t maxLeaf = abcd[0];
+
+  runCpuid(1, 0, abcd);
+  const uint32_t ecx1 = abcd[2];
+  const uint32_t edx1 = abcd[3];
+  f.sse2 = (edx1 & (1u << 26)) != 0;
+  f.sse41 = (ecx1 & (1u << 19)) != 0;
+
+  // The AVX family also needs the OS to save the XMM and YMM state (OSXSAVE + XCR0)
+  const bool osxsave = (ecx1 & (1u << 27)) != 0;
+  const uint32_t xcr0 = osxsave ? readXcr0() : 0;
+  const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+  // opmask, upper ZMM0-15 and ZMM16-31 state
+  const bool zmmEnabled = ymmEnabled && (xcr0 & 0xe0) == 0xe0;
+
+  f.avx = ymmEnabled && (ecx1 & (1u << 28)) != 0;
+  f.fma = f.avx && (ecx1 & (1u << 12)) != 0;
+  f.f16c = f.avx && (ecx1 & (1u << 29)) != 0;
+
+  if (maxLeaf >= 7) {
+    runCpuid(7, 0, abcd);
+    f.avx2 = f.avx && (abcd[1] & (1u << 5)) != 0;
+    f.avx512f = zmmEnabled && (abcd[1] & (1u << 16)) != 0;
+  }
+  return f;
+}
+#else
+Features detect() {
+  Features f;
+#ifdef __ARM_NEON
+  f.neon = true;
+#endif
+  return f;
+}
+#endif // TBE_CPU_X86
+
+//
+// Tiers compiled into the library. The static single-ISA build only has its own tier.
+//
+bool tierBuilt(Tier tier) {
+#if defined(TBE_STATIC_ISA_SCALAR)
+  return tier == Tier::SCALAR;
+#elif defined(TBE_STATIC_ISA_SSE)
+  return tier == Tier::SSE;
+#elif defined(TBE_STATIC_ISA_AVX)
+  return tier == Tier::AVX;
+#elif defined(TBE_STATIC_ISA_NEON)
+  return tier == Tier::NEON;
+#else
+  switch (tier) {
+    case Tier::SCALAR:
+      return true;
+#if defined(TBE_CPU_X86) && !defined(TBE_DISABLE_SIMD)
+    case Tier::SSE:
+      return true;
+#ifndef TBE_DISABLE_AVX
+    case Tier::AVX:
+      return true;
+#endif
+#endif
+#ifdef __ARM_NEON
+    case Tier::NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+#endif
+}
+
+bool tierFromName(const char* name, Tier* tier) {
+  const Tier tiers[] = {Tier::SCALAR, Tier::SSE, Tier::AVX, Tier::NEON};
+  for (Tier t : tiers) {
+    if (strcmp(name, tierName(t)) == 0) {
+      *tier = t;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::atomic<int> tierOverride{-1};
+std::atomic<bool> tierResolved{false};
+
+Tier resolveTier() {
+  tierResolved = true;
+
+  const int pinned = tierOverride.load();
+  if (pinned >= 0) {
+    return static_cast<Tier>(pinned);
+  }
+
+  const char* env = getenv("TBE_DSP_TIER");
+  Tier tier;
+  if (env && tierFromName(env, &tier) && tierSupported(tier)) {
+    return tier;
+  }
+  return bestTier();
+}
+} // namespace
+
+const Features& features() {
+  // Thread safe static initialisation, cpuid runs once per process
+  static const Features f = detect();
+  return f;
+}
+
+const char* tierName(Tier tier) {
+  switch (tier) {
+    case Tier::SCALAR:
+      return "scalar";
+    case Tier::SSE:
+      return "sse";
+    case Tier::AVX:
+      return "avx";
+    case Tier::NEON:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool tierSupported(Tier tier) {
+  if (!tierBuilt(tier)) {
+    return false;
+  }
+
+  const Features& f = features();
+  switch (tier) {
+    case Tier::SCALAR:
+      return true;
+    case Tier::SSE:
+      return f.sse2;
+    case Tier::AVX:
+      return f.avx;
+    case Tier::NEON:
+      return f.neon;
+  }
+  return false;
+}
+
+std::vector<Tier> supportedTiers() {
+  std::vector<Tier> result;
+  const Tier tiers[] = {Tier::SCALAR, Tier::SSE, Tier::AVX, Tier::NEON};
+  for (Tier tier : tiers) {
+    if (tierSupported(tier)) {
+      result.push_back(tier);
+    }
+  }
+  return result;
+}
+
+Tier bestTier() {
+  const Tier tiers[] = {Tier::AVX, Tier::SSE, Tier::NEON};
+  for (Tier tier : tiers) {
+    if (tierSupported(tier)) {
+      return tier;
+    }
+  }
+  return Tier::SCALAR;
+}
+
+Tier selectedTier() {
+  static const Tier tier = resolveTier();
+  return tier;
+}
+
+bool setTierOverride(Tier tier) {
+  if (!tierSupported(tier) || tierResolved) {
+    return false;
+  }
+  tierOverride = static_cast<int>(tier);
+  return true;
+}
+} // namespace CPU
+} // namespace TBE
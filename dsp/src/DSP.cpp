@@ -8,7 +8,6 @@
 #ifndef __ARM_NEON
 
 #include "DSP.hh"
-#include "CpuFeatures.hh"
 #include "Internal.hh"
 
 #ifndef TBE_DISABLE_SIMD
@@ -20,34 +19,50 @@
 #include <intrin.h>
 #endif
 
+#ifndef TBE_STATIC_ISA
 namespace TBE {
 
 //-----------------------------------
 extern void dspInitAVX(FBDSP* d);
 extern void dspInitSSE(FBDSP* d);
 
-FBDSP::FBDSP() {
-#ifdef TBE_DISABLE_SIMD
-  Internal::dspInit<float>(this);
-#elif defined(TBE_DISABLE_AVX)
-  dspInitSSE(this);
-#else
-  (CPU::avxAvailable()) ? dspInitAVX(this) : dspInitSSE(this);
+FBDSP::FBDSP(CPU::Tier tier) {
+  assert(CPU::tierSupported(tier));
+  switch (tier) {
+#ifndef TBE_DISABLE_SIMD
+    case CPU::Tier::SSE:
+      dspInitSSE(this);
+      break;
+#ifndef TBE_DISABLE_AVX
+    case CPU::Tier::AVX:
+      dspInitAVX(this);
+      break;
+#endif
 #endif
+    default:
+      Internal::dspInit<float>(this);
+      break;
+  }
 }
 
 //-----------------------------------
 
-void FIR::process(const float* input, float* output, size_t numSamples) {
-#ifdef TBE_DISABLE_SIMD
-  processLinear(input, output, numSamples);
-#elif defined(TBE_DISABLE_AVX)
-  processSSE(input, output, numSamples);
-#else
-  avxAvailable_ ? processAVX(input, output, numSamples) : processSSE(input, output, numSamples);
+FIR::ProcessFn FIR::processForTier(CPU::Tier tier) {
+  switch (tier) {
+#ifndef TBE_DISABLE_SIMD
+    case CPU::Tier::SSE:
+      return &FIR::processSSE;
+#ifndef TBE_DISABLE_AVX
+    case CPU::Tier::AVX:
+      return &FIR::processAVX;
+#endif
 #endif
+    default:
+      return &FIR::processScalar;
+  }
 }
 
 } // namespace TBE
+#endif // TBE_STATIC_ISA
 
 #endif // __ARM_NEON
@@ -15,25 +15,43 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include "Arena.hh"
+#include "CpuFeatures.hh"
+#include "MemoryFootprint.hh"
+#include "RegOps.hh"
+#include "SharedIR.hh"
+
+//
+// Static single-ISA mode, selected with TBE_STATIC_ISA in CMake. The kernels are bound at build
+// time to one RegOps type instead of being dispatched at runtime, so they can be inlined into
+// their callers. Runtime dispatch is used when none of these is defined.
+//
+#if defined(TBE_STATIC_ISA_SCALAR)
+#define TBE_STATIC_ISA 1
+#define TBE_STATIC_REG float
+#elif defined(TBE_STATIC_ISA_SSE)
+#include "RegOpsSSE.hh"
+#define TBE_STATIC_ISA 1
+#define TBE_STATIC_REG __m128
+#elif defined(TBE_STATIC_ISA_AVX)
+#include "RegOpsAVX.hh"
+#define TBE_STATIC_ISA 1
+#define TBE_STATIC_REG __m256
+#elif defined(TBE_STATIC_ISA_NEON)
+#include "RegOpsNeon.hh"
+#define TBE_STATIC_ISA 1
+#define TBE_STATIC_REG float32x4_t
+#endif
+
+#ifdef TBE_STATIC_ISA
+#include "Denormals.hh"
+#endif
 
 namespace TBE {
-template <typename T>
-struct RegOps {
-  static size_t width();
-  static T zero();
-  static T mul(T& a, T& b);
-  static T mul(T& a, float& scalar);
-  static T add(T& a, T& b);
-  static T set(float& val);
-  static T mulAcc(T& acc, T& a, T& b);
-  static T loadU(const float* buffer);
-  static void storeU(float* buffer, T& a);
-};
-
-static const float kLinear96dB = 0.000015848932f;
 
+#ifndef TBE_STATIC_ISA
 /// A helper class for SIMD optimised functions supporting AVX, SSE and NEON. The functions are
-/// loaded on runtime based on the CPU type. Typical use: FBDSP dsp; dsp.multiply(inoutA, inputB,
+/// loaded on runtime based on the CPU type. Typical use: FBDSP::shared().multiply(inoutA, inputB,
 /// output, numOfSamples);
 class FBDSP {
  public:
@@ -82,8 +100,268 @@ class FBDSP {
 
   bool (*isBufferSilent)(const float* input, size_t numOfSamples){nullptr};
 
+  /// Scale a buffer, add another one, apply an output gain and clip the result, all in a single
+  /// pass over the buffers (output[i] = clip((a[i] * scalar + b[i]) * outputGain, -clipLevel,
+  /// clipLevel)). Built from the expression templates in Expression.hh.
+  /// \param inputToScale Buffer to scale
+  /// \param scalar Scalar value applied to inputToScale
+  /// \param bufferToAdd Buffer to add to inputToScale after it is scaled
+  /// \param outputGain Gain applied to the sum
+  /// \param clipLevel Largest absolute value in the output
+  /// \param output Output buffer where the result is written to, may be one of the inputs
+  /// \param numOfSamples Number of samples in the buffers
+  void (*mixAndClip)(
+      const float* inputToScale,
+      float scalar,
+      const float* bufferToAdd,
+      float outputGain,
+      float clipLevel,
+      float* output,
+      size_t numOfSamples){nullptr};
+
+  /// Find the largest absolute value in a buffer (max(|input[i]|))
+  /// \param input Input buffer
+  /// \param numOfSamples Number of samples in the buffer
+  /// \return The peak value, 0 for an empty buffer, NaN if any of the values is NaN
+  float (*peak)(const float* input, size_t numOfSamples){nullptr};
+
+  /// Sum all the values in a buffer (sum of input[i])
+  /// \param input Input buffer
+  /// \param numOfSamples Number of samples in the buffer
+  float (*sum)(const float* input, size_t numOfSamples){nullptr};
+
+  /// Sum the squared values in a buffer, its energy (sum of input[i] * input[i])
+  /// \param input Input buffer
+  /// \param numOfSamples Number of samples in the buffer
+  float (*sumOfSquares)(const float* input, size_t numOfSamples){nullptr};
+
+  /// Dot product of two buffers (sum of a[i] * b[i])
+  /// \param inputA Input buffer A
+  /// \param inputB Input buffer B
+  /// \param numOfSamples Number of samples in the buffers
+  float (*dotProduct)(const float* inputA, const float* inputB, size_t numOfSamples){nullptr};
+
+  /// Find the smallest and largest values in a buffer in a single pass
+  /// \param input Input buffer
+  /// \param numOfSamples Number of samples in the buffer
+  /// \param minValue Where the smallest value is written to, +inf for an empty buffer
+  /// \param maxValue Where the largest value is written to, -inf for an empty buffer
+  void (*minMax)(const float* input, size_t numOfSamples, float* minValue, float* maxValue){
+      nullptr};
+
+  /// Convert signed 16 bit samples to floats in [-1, 1) (output[i] = input[i] / 32768)
+  /// \param input Input samples
+  /// \param output Output buffer where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*convertInt16ToFloat)(const int16_t* input, float* output, size_t numOfSamples){nullptr};
+
+  /// Convert floats to signed 16 bit samples, rounding to nearest and saturating out of range
+  /// values. NaN converts to 0.
+  /// \param input Input buffer
+  /// \param output Output samples
+  /// \param numOfSamples Number of samples in the buffers
+  /// \param ditherState State of the TPDF dither generator, kept by the caller between calls. Pass
+  /// nullptr to convert without dither
+  void (*convertFloatToInt16)(
+      const float* input,
+      int16_t* output,
+      size_t numOfSamples,
+      uint32_t* ditherState){nullptr};
+
+  /// Convert packed little endian signed 24 bit samples (3 bytes per sample) to floats in [-1, 1)
+  /// \param input Input bytes, 3 * numOfSamples of them
+  /// \param output Output buffer where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*convertInt24ToFloat)(const uint8_t* input, float* output, size_t numOfSamples){nullptr};
+
+  /// Convert floats to packed little endian signed 24 bit samples (3 bytes per sample), rounding
+  /// to nearest and saturating out of range values. NaN converts to 0.
+  /// \param input Input buffer
+  /// \param output Output bytes, 3 * numOfSamples of them
+  /// \param numOfSamples Number of samples in the buffers
+  /// \param ditherState State of the TPDF dither generator, kept by the caller between calls. Pass
+  /// nullptr to convert without dither
+  void (*convertFloatToInt24)(
+      const float* input,
+      uint8_t* output,
+      size_t numOfSamples,
+      uint32_t* ditherState){nullptr};
+
+  /// Convert signed 32 bit samples to floats in [-1, 1) (output[i] = input[i] / 2^31)
+  /// \param input Input samples
+  /// \param output Output buffer where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*convertInt32ToFloat)(const int32_t* input, float* output, size_t numOfSamples){nullptr};
+
+  /// Convert floats to signed 32 bit samples, rounding to nearest and saturating out of range
+  /// values. NaN converts to 0.
+  /// \param input Input buffer
+  /// \param output Output samples
+  /// \param numOfSamples Number of samples in the buffers
+  void (*convertFloatToInt32)(const float* input, int32_t* output, size_t numOfSamples){nullptr};
+
+  /// Interleave planar buffers into frames (output[n * numChannels + ch] = inputs[ch][n])
+  /// \param inputs Array of numChannels input buffers
+  /// \param numChannels Number of channels
+  /// \param output Output buffer of numFrames * numChannels samples
+  /// \param numFrames Number of samples in each input buffer
+  void (*interleave)(const float** inputs, size_t numChannels, float* output, size_t numFrames){
+      nullptr};
+
+  /// Split interleaved frames into planar buffers (outputs[ch][n] = input[n * numChannels + ch])
+  /// \param input Input buffer of numFrames * numChannels samples
+  /// \param numChannels Number of channels
+  /// \param outputs Array of numChannels output buffers
+  /// \param numFrames Number of samples in each output buffer
+  void (*deinterleave)(const float* input, size_t numChannels, float** outputs, size_t numFrames){
+      nullptr};
+
+  /// Multiply a buffer with a gain ramped linearly from startGain on the first sample towards
+  /// endGain, which is reached on the first sample of the next buffer
+  /// (output[i] = input[i] * (startGain + (endGain - startGain) * i / numOfSamples))
+  /// \param input Input buffer
+  /// \param startGain Gain applied to the first sample
+  /// \param endGain Gain the ramp ends on
+  /// \param output Output buffer where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*multiplyRamp)(
+      const float* input,
+      float startGain,
+      float endGain,
+      float* output,
+      size_t numOfSamples){nullptr};
+
+  /// Multiply a buffer with a gain ramped exponentially (linearly in dB) from startGain on the
+  /// first sample towards endGain, which is reached on the first sample of the next buffer
+  /// (output[i] = input[i] * startGain * (endGain / startGain)^(i / numOfSamples)). Both gains
+  /// must be non-zero and have the same sign.
+  /// \param input Input buffer
+  /// \param startGain Gain applied to the first sample
+  /// \param endGain Gain the ramp ends on
+  /// \param output Output buffer where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*multiplyRampExp)(
+      const float* input,
+      float startGain,
+      float endGain,
+      float* output,
+      size_t numOfSamples){nullptr};
+
+  /// Multiply the input buffer with a linearly ramped gain (as in multiplyRamp) and then sum the
+  /// result with another buffer
+  /// \param inputToScale Buffer to scale
+  /// \param startGain Gain applied to the first sample
+  /// \param endGain Gain the ramp ends on
+  /// \param bufferToAdd Buffer to add to inputToScale after it is scaled
+  /// \param output Output buffer where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*multiplyRampAndAdd)(
+      const float* inputToScale,
+      float startGain,
+      float endGain,
+      const float* bufferToAdd,
+      float* output,
+      size_t numOfSamples){nullptr};
+
+  /// Multiply the input buffer with an exponentially ramped gain (as in multiplyRampExp) and then
+  /// sum the result with another buffer
+  /// \param inputToScale Buffer to scale
+  /// \param startGain Gain applied to the first sample
+  /// \param endGain Gain the ramp ends on
+  /// \param bufferToAdd Buffer to add to inputToScale after it is scaled
+  /// \param output Output buffer where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*multiplyRampExpAndAdd)(
+      const float* inputToScale,
+      float startGain,
+      float endGain,
+      const float* bufferToAdd,
+      float* output,
+      size_t numOfSamples){nullptr};
+
+  /// Mix a set of input buffers into a set of output buffers through a gain matrix
+  /// (outputs[j][n] = sum over i of gains[j * numInputs + i] * inputs[i][n]). Several outputs are
+  /// accumulated per pass over the inputs. The outputs must not alias any of the inputs.
+  /// \param inputs Array of numInputs input buffers
+  /// \param numInputs Number of input buffers
+  /// \param gains Row-major gain matrix of numOutputs rows and numInputs columns
+  /// \param outputs Array of numOutputs output buffers where the result is written to
+  /// \param numOutputs Number of output buffers
+  /// \param numOfSamples Number of samples in the buffers
+  void (*matrixMix)(
+      const float** inputs,
+      size_t numInputs,
+      const float* gains,
+      float** outputs,
+      size_t numOutputs,
+      size_t numOfSamples){nullptr};
+
+  /// Mix a set of input buffers through a gain matrix and add the result to the output buffers
+  /// (outputs[j][n] += sum over i of gains[j * numInputs + i] * inputs[i][n]). The outputs must not
+  /// alias any of the inputs.
+  /// \param inputs Array of numInputs input buffers
+  /// \param numInputs Number of input buffers
+  /// \param gains Row-major gain matrix of numOutputs rows and numInputs columns
+  /// \param outputs Array of numOutputs output buffers the result is added to
+  /// \param numOutputs Number of output buffers
+  /// \param numOfSamples Number of samples in the buffers
+  void (*matrixMixAdd)(
+      const float** inputs,
+      size_t numInputs,
+      const float* gains,
+      float** outputs,
+      size_t numOutputs,
+      size_t numOfSamples){nullptr};
+
+  /// Mix channels through a block-diagonal gain matrix, such as an Ambisonic rotation where each
+  /// order only mixes with itself. Block b maps blockSizes[b] consecutive input channels to the
+  /// same number of consecutive output channels. The outputs must not alias any of the inputs.
+  /// \param inputs Array of input buffers, as many as the sum of blockSizes
+  /// \param gains The square row-major matrices of every block, one after the other
+  /// \param blockSizes Number of channels in each block
+  /// \param numBlocks Number of blocks
+  /// \param outputs Array of output buffers where the result is written to
+  /// \param numOfSamples Number of samples in the buffers
+  void (*matrixMixBlockDiagonal)(
+      const float** inputs,
+      const float* gains,
+      const size_t* blockSizes,
+      size_t numBlocks,
+      float** outputs,
+      size_t numOfSamples){nullptr};
+
+  /// Mix a set of input buffers into a set of output buffers through a gain matrix interpolated
+  /// linearly on every sample, from gainsStart on the first sample towards gainsEnd which is
+  /// reached on the first sample of the next buffer. The outputs must not alias any of the inputs.
+  /// \param inputs Array of numInputs input buffers
+  /// \param numInputs Number of input buffers
+  /// \param gainsStart Row-major gain matrix at the start of the buffer
+  /// \param gainsEnd Row-major gain matrix at the end of the buffer
+  /// \param outputs Array of numOutputs output buffers where the result is written to
+  /// \param numOutputs Number of output buffers
+  /// \param numOfSamples Number of samples in the buffers
+  void (*matrixMixInterpolated)(
+      const float** inputs,
+      size_t numInputs,
+      const float* gainsStart,
+      const float* gainsEnd,
+      float** outputs,
+      size_t numOutputs,
+      size_t numOfSamples){nullptr};
+
+  /// Copies the process-wide table from shared(), no CPU detection takes place
   FBDSP();
+
+  /// Fill in the kernels of a specific tier, e.g. to compare tiers in tests and benchmarks
+  /// \param tier The tier, must be supported (see CPU::tierSupported)
+  explicit FBDSP(CPU::Tier tier);
+
+  /// \return The process-wide table of kernels for CPU::selectedTier(). It is resolved once, on
+  /// first use, and never modified afterwards, so objects can hold a pointer to it instead of a
+  /// copy.
+  static const FBDSP& shared();
 };
+#endif // TBE_STATIC_ISA
 
 class FIR {
  public:
@@ -98,26 +376,103 @@ class FIR {
   FIR(size_t numTaps);
   FIR(const float* ir, size_t numTaps);
 
+  //
+  // Take the taps and the delay line from an arena instead of the heap, so a renderer can keep
+  // all of its filters in one block. The arena must outlive the FIR.
+  //
+  FIR(const float* ir, size_t numTaps, Arena& arena);
+
+  //
+  // Read the taps from a SharedIR instead of a private copy, so filters on the same IR share one
+  // set of coefficients and only keep their own delay line, on the heap or in an arena.
+  //
+  explicit FIR(SharedIR::Ptr ir);
+  FIR(SharedIR::Ptr ir, Arena& arena);
+
+  //
+  // The number of arena bytes used by a FIR of numTaps
+  //
+  static size_t arenaSize(size_t numTaps) {
+    return Arena::sizeOf<float>(numTaps) + sharedIRArenaSize(numTaps);
+  }
+
+  //
+  // The number of arena bytes used by a FIR of numTaps on a SharedIR: the delay line only
+  //
+  static size_t sharedIRArenaSize(size_t numTaps) {
+    return Arena::sizeOf<float>(2 * numTaps);
+  }
+
   //
   // This function will process the FIR in the best available SIMD mode (SSE, AVX, Neon)
-  // If SIMD is disabled by TBE_DISABLE_SIMD it will defer to processLinear.
+  // If SIMD is disabled by TBE_DISABLE_SIMD it will use the scalar tier, one float per register.
+  // In the static single-ISA mode it is bound at build time and inlined.
   //
+#ifdef TBE_STATIC_ISA
+  void process(const float* input, float* output, size_t numSamples) {
+    ScopedDenormalGuard guard(denormalProtection_);
+    process<TBE_STATIC_REG>(input, output, numSamples);
+    if (denormalProtection_ && !guard.isActive()) {
+      flushDenormalState(output, numSamples);
+    }
+  }
+#else
   void process(const float* input, float* output, size_t numSamples);
 
+  //
+  // Process with the implementation of a specific tier instead of the selected one, e.g. to
+  // compare the tiers in tests and benchmarks. The tier must be supported (CPU::tierSupported).
+  // Use one tier for the lifetime of a FIR, as its delay line carries over from call to call.
+  //
+  void process(CPU::Tier tier, const float* input, float* output, size_t numSamples);
+#endif
+
   //
   // This function will process the FIR in non-vectorized 'linear' way. It does not
   // use any SIMD instruction. It is usseful for very small ( < 64 samples ) signals / IRs
   // where it could possibly outperform the SIMD implementation
+  // It keeps its delay line in another order than process(): use one or the other on a FIR.
   //
   void processLinear(const float* input, float* output, size_t numSamples);
 
+  //
+  // Flush denormals to zero while processing. Decaying IR tails and silence leave denormals in the
+  // accumulators and the delay line, which are several times slower on x86. Uses
+  // ScopedDenormalGuard, or flushes the delay line and the output after each call where the
+  // platform has no FTZ/DAZ flags. Off by default.
+  //
+  void setDenormalProtection(bool enabled) {
+    denormalProtection_ = enabled;
+  }
+
+  bool getDenormalProtection() const {
+    return denormalProtection_;
+  }
+
+  //
+  // The taps as coefficients, shared if they come from a SharedIR, the delay line and the FIR
+  // object itself as state. Taken from an arena they are counted with their alignment padding.
+  //
+  MemoryFootprint memoryFootprint() const;
+
  private:
-  void init();
-  void init(float const* ir, size_t numSamples);
-  void setIR(float const* ir, size_t numSamples); // NOT thread safe in any way!
+  void init(float* taps);
+  void init(float* taps, float const* ir, size_t numSamples);
+  void setIR(float* taps, float const* ir, size_t numSamples); // NOT thread safe in any way!
   void processSerial(const float* input, float* output, size_t numSamples);
+  void processScalar(const float* input, float* output, size_t numSamples);
   void processSSE(const float* input, float* output, size_t numSamples);
   void processAVX(const float* input, float* output, size_t numSamples);
+  void processNeon(const float* input, float* output, size_t numSamples);
+  void flushDenormalState(float* output, size_t numSamples);
+
+#ifndef TBE_STATIC_ISA
+  using ProcessFn = void (FIR::*)(const float* input, float* output, size_t numSamples);
+
+  // The process implementation of a tier. process() resolves it once per process for
+  // CPU::selectedTier()
+  static ProcessFn processForTier(CPU::Tier tier);
+#endif
 
   template <typename TReg>
   void process(const float* input, float* output, size_t numSamples) {
@@ -145,16 +500,17 @@ class FIR {
     // Store the begining samples from the input in the second half of the delay line
     // after the current delay. This will be used for the initial paralel run.
     size_t len = numSamples < numTaps ? numSamples : numTaps;
-    memcpy(&delay_.get()[numTaps], input, sizeof(float) * len);
+    memcpy(&delay_[numTaps], input, sizeof(float) * len);
 
+    // Only the outputs whose taps all sit in the delay line, the pipeline starts at numTaps - 1
     outputIdx = 0;
-    while (inputIdx < numTaps && outputIdx + regWidth <= numSamples) {
+    while (outputIdx + regWidth <= len) {
       acc1 = RegOps<TReg>::zero();
 
       for (coefIdx = 0; coefIdx < numTaps; ++coefIdx) {
-        assert(inputIdx + coefIdx < numTaps * 2);
+        assert(inputIdx + coefIdx + regWidth < numTaps * 2);
         c1 = RegOps<TReg>::set(ir_[coefIdx]);
-        i1 = RegOps<TReg>::loadU(delay_.get() + inputIdx + coefIdx + 1);
+        i1 = RegOps<TReg>::loadU(delay_ + inputIdx + coefIdx + 1);
         acc1 = RegOps<TReg>::mulAcc(acc1, i1, c1);
       }
       assert(outputIdx < numSamples);
@@ -164,19 +520,15 @@ class FIR {
     }
 
     //
-    // If all that remains are a few samples that can't fit in a line
-    // process them here taking the input from the delay_ line
+    // The few samples of the delay line that can't fit in a line
     //
-    if (numSamples - outputIdx < 8) {
+    while (outputIdx < len) {
       float outputSample = 0;
-      while (outputIdx < numSamples) {
-        outputSample = 0;
-        for (size_t i = 0; i < numTaps; ++i) {
-          outputSample += delay_.get()[numTaps + outputIdx - i] * ir_[numTaps - 1 - i];
-        }
-        assert(outputIdx < numSamples);
-        output[outputIdx++] = outputSample;
+      for (size_t i = 0; i < numTaps; ++i) {
+        outputSample += delay_[numTaps + outputIdx - i] * ir_[numTaps - 1 - i];
       }
+      assert(outputIdx < numSamples);
+      output[outputIdx++] = outputSample;
     }
 
     //
@@ -184,7 +536,7 @@ class FIR {
     //
     size_t tailSamples = numSamples > numTaps ? numTaps : numSamples;
     if (tailSamples < numTaps) {
-      memcpy(delay_.get(), &delay_.get()[tailSamples], (numTaps - tailSamples) * sizeof(float));
+      memmove(delay_, &delay_[tailSamples], (numTaps - tailSamples) * sizeof(float));
     }
 
     //
@@ -197,7 +549,7 @@ class FIR {
     size_t const delaySrcIdx = numSamples - tailSamples;
 
     assert(delayDestIdx + tailSamples <= numTaps);
-    memcpy(&delay_.get()[delayDestIdx], &input[delaySrcIdx], tailSamples * sizeof(float));
+    memcpy(&delay_[delayDestIdx], &input[delaySrcIdx], tailSamples * sizeof(float));
 
     //
     // Now process the pipeline.
@@ -275,9 +627,15 @@ class FIR {
     }
   }
 
-  const bool avxAvailable_;
   size_t numTaps_;
-  IRMem ir_;
-  IRMem delay_;
+  IRMem memory_; // Taps and delay line, or the delay line only, when not taken from an arena
+  SharedIR::Ptr sharedIR_; // Holds the taps when they are shared
+  const float* ir_;
+  float* delay_;
+  bool denormalProtection_{false};
 };
 } // namespace TBE
+
+#ifdef TBE_STATIC_ISA
+#include "StaticDSP.hh"
+#endif
@@ -5,53 +5,126 @@
  LICENSE file in the root directory of this source tree.
  */
 
-#include "CpuFeatures.hh"
 #include "DSP.hh"
+#include "Denormals.hh"
 
 namespace TBE {
+#ifndef TBE_STATIC_ISA
+FBDSP::FBDSP() : FBDSP(shared()) {}
+
+const FBDSP& FBDSP::shared() {
+  // Thread safe static initialisation, the tier is only resolved once per process
+  static const FBDSP dsp{CPU::selectedTier()};
+  return dsp;
+}
+
+void FIR::process(const float* input, float* output, size_t numSamples) {
+  // Shared by all filters, thread safe static initialisation
+  static const ProcessFn processImpl = processForTier(CPU::selectedTier());
+
+  ScopedDenormalGuard guard(denormalProtection_);
+  (this->*processImpl)(input, output, numSamples);
+  if (denormalProtection_ && !guard.isActive()) {
+    flushDenormalState(output, numSamples);
+  }
+}
+
+void FIR::process(CPU::Tier tier, const float* input, float* output, size_t numSamples) {
+  assert(CPU::tierSupported(tier));
+  const ProcessFn processImpl = processForTier(tier);
+
+  ScopedDenormalGuard guard(denormalProtection_);
+  (this->*processImpl)(input, output, numSamples);
+  if (denormalProtection_ && !guard.isActive()) {
+    flushDenormalState(output, numSamples);
+  }
+}
+#endif // TBE_STATIC_ISA
+
 FIR::FIR(size_t numTaps)
-    : avxAvailable_(CPU::avxAvailable()),
-      numTaps_(numTaps),
-      ir_{new float[numTaps]},
-      delay_{new float[2 * numTaps]} {
+    : numTaps_(numTaps), memory_{new float[3 * numTaps]}, delay_{memory_.get() + numTaps} {
   assert(numTaps >= 8);
-  init();
+  init(memory_.get());
 }
 
 FIR::FIR(const float* ir, size_t numTaps)
-    : avxAvailable_(CPU::avxAvailable()),
-      numTaps_(numTaps),
-      ir_(new float[numTaps]),
-      delay_{new float[2 * numTaps]} {
+    : numTaps_(numTaps), memory_{new float[3 * numTaps]}, delay_{memory_.get() + numTaps} {
+  assert(numTaps >= 8);
+  init(memory_.get(), ir, numTaps);
+}
+
+FIR::FIR(const float* ir, size_t numTaps, Arena& arena)
+    : numTaps_(numTaps), delay_{nullptr} {
   assert(numTaps >= 8);
-  init(ir, numTaps);
+  float* taps = arena.allocate<float>(numTaps);
+  delay_ = arena.allocate<float>(2 * numTaps);
+  init(taps, ir, numTaps);
+}
+
+FIR::FIR(SharedIR::Ptr ir)
+    : numTaps_(ir->getNumTaps()),
+      memory_{new float[2 * ir->getNumTaps()]},
+      sharedIR_(std::move(ir)),
+      ir_{sharedIR_->getTaps()},
+      delay_{memory_.get()} {
+  assert(numTaps_ >= 8);
+  memset(delay_, 0, sizeof(float) * numTaps_ * 2);
 }
 
-void FIR::init() {
-  memset(ir_.get(), 0, sizeof(float) * numTaps_);
-  memset(delay_.get(), 0, sizeof(float) * numTaps_ * 2);
-  ir_.get()[numTaps_ - 1] = 1; // Default to Dirac delta function (reversed IR)
+FIR::FIR(SharedIR::Ptr ir, Arena& arena)
+    : numTaps_(ir->getNumTaps()),
+      sharedIR_(std::move(ir)),
+      ir_{sharedIR_->getTaps()},
+      delay_{arena.allocate<float>(2 * numTaps_)} {
+  assert(numTaps_ >= 8);
+  memset(delay_, 0, sizeof(float) * numTaps_ * 2);
 }
 
-void FIR::init(float const* ir, size_t numSamples) {
-  memset(ir_.get(), 0, sizeof(float) * numTaps_);
-  memset(delay_.get(), 0, sizeof(float) * numTaps_ * 2);
-  setIR(ir, numSamples);
+void FIR::init(float* taps) {
+  memset(taps, 0, sizeof(float) * numTaps_);
+  memset(delay_, 0, sizeof(float) * numTaps_ * 2);
+  taps[numTaps_ - 1] = 1; // Default to Dirac delta function (reversed IR)
+  ir_ = taps;
 }
 
-void FIR::setIR(float const* ir, size_t numSamples) {
+void FIR::init(float* taps, float const* ir, size_t numSamples) {
+  memset(taps, 0, sizeof(float) * numTaps_);
+  memset(delay_, 0, sizeof(float) * numTaps_ * 2);
+  setIR(taps, ir, numSamples);
+  ir_ = taps;
+}
+
+void FIR::setIR(float* taps, float const* ir, size_t numSamples) {
   assert(numSamples <= numTaps_);
 
   for (size_t i = 1; i <= numSamples; ++i) {
-    ir_[numTaps_ - i] = ir[i - 1]; // reverse the ir...
+    taps[numTaps_ - i] = ir[i - 1]; // reverse the ir...
   };
 }
 
+MemoryFootprint FIR::memoryFootprint() const {
+  MemoryFootprint footprint;
+  if (sharedIR_) {
+    footprint.coefficients.sharedBytes = sharedIR_->getSize();
+    footprint.state.privateBytes =
+        memory_ ? 2 * numTaps_ * sizeof(float) : sharedIRArenaSize(numTaps_);
+  } else if (memory_) {
+    footprint.coefficients.privateBytes = numTaps_ * sizeof(float);
+    footprint.state.privateBytes = 2 * numTaps_ * sizeof(float);
+  } else {
+    footprint.coefficients.privateBytes = Arena::sizeOf<float>(numTaps_);
+    footprint.state.privateBytes = sharedIRArenaSize(numTaps_);
+  }
+  footprint.state.privateBytes += sizeof(FIR);
+  return footprint;
+}
+
 //
 // Straight up, non-vectorized implementation for cases where we can not
 // use intrinsics
 //
 void FIR::processLinear(const float* input, float* output, size_t numSamples) {
+  ScopedDenormalGuard guard(denormalProtection_);
   float x, y;
   for (size_t i = 0; i < numSamples; ++i) {
     x = input[i];
@@ -59,10 +132,30 @@ void FIR::processLinear(const float* input, float* output, size_t numSamples) {
     for (size_t s = 1; s < numTaps_; ++s) {
       y += ir_[numTaps_ - 1 - s] * delay_[s - 1];
     }
-    memcpy(&delay_[1], &delay_[0], sizeof(float) * (numTaps_ - 1));
+    memmove(&delay_[1], &delay_[0], sizeof(float) * (numTaps_ - 1));
     delay_[0] = x;
     output[i] = y;
   }
+
+  if (denormalProtection_ && !guard.isActive()) {
+    flushDenormalState(output, numSamples);
+  }
+}
+
+//
+// The scalar tier: the vectorized implementation on registers of one float
+//
+void FIR::processScalar(const float* input, float* output, size_t numSamples) {
+  process<float>(input, output, numSamples);
+}
+
+//
+// Denormal protection fallback for platforms without FTZ/DAZ. Flushing the state keeps denormals
+// from piling up in the delay line once the input has decayed
+//
+void FIR::flushDenormalState(float* output, size_t numSamples) {
+  flushDenormals(delay_, 2 * numTaps_);
+  flushDenormals(output, numSamples);
 }
 
 //
@@ -81,13 +174,13 @@ void FIR::processSerial(const float* input, float* output, size_t numSamples) {
   // Store the begining samples from the input in the tail line
   // after the delay line section, this will be used for the run
   size_t len = numSamples < numTaps ? numSamples : numTaps;
-  memcpy(&delay_.get()[numTaps], input, sizeof(float) * len);
+  memcpy(&delay_[numTaps], input, sizeof(float) * len);
 
   float outputSample = 0;
   while (outputIdx < numSamples) {
     outputSample = 0;
     for (size_t i = 0; i < numTaps; ++i) {
-      outputSample += delay_.get()[numTaps + outputIdx - i] * ir_[numTaps - 1 - i];
+      outputSample += delay_[numTaps + outputIdx - i] * ir_[numTaps - 1 - i];
     }
     assert(outputIdx < numSamples);
     output[outputIdx++] = outputSample;
@@ -95,7 +188,7 @@ void FIR::processSerial(const float* input, float* output, size_t numSamples) {
 
   size_t tailSamples = numSamples > numTaps ? numTaps : numSamples;
   if (tailSamples < numTaps) {
-    memcpy(delay_.get(), &delay_.get()[tailSamples], (numTaps - tailSamples) * sizeof(float));
+    memmove(delay_, &delay_[tailSamples], (numTaps - tailSamples) * sizeof(float));
   }
 
   //
@@ -104,6 +197,6 @@ void FIR::processSerial(const float* input, float* output, size_t numSamples) {
   //
   size_t const delayDestIdx = numTaps - tailSamples;
   size_t const delaySrcIdx = numSamples - tailSamples;
-  memcpy(&delay_.get()[delayDestIdx], &input[delaySrcIdx], tailSamples * sizeof(float));
+  memcpy(&delay_[delayDestIdx], &input[delaySrcIdx], tailSamples * sizeof(float));
 }
 } // namespace TBE
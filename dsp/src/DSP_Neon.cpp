@@ -9,48 +9,12 @@
 
 #ifdef __ARM_NEON
 
-#include <arm_neon.h>
 #include "Internal.hh"
+#include "RegOpsNeon.hh"
 
+// The static single-ISA mode binds the kernels in StaticDSP.hh instead
+#ifndef TBE_STATIC_ISA
 namespace TBE {
-template <>
-struct RegOps<float32x4_t> {
-  static size_t width() {
-    return 4;
-  }
-
-  static float32x4_t zero() {
-    return vdupq_n_f32(0);
-  }
-
-  static float32x4_t mul(float32x4_t& a, float32x4_t& b) {
-    return vmulq_f32(a, b);
-  }
-
-  static float32x4_t mul(float32x4_t& v, float& scalar) {
-    return vmulq_n_f32(v, scalar);
-  }
-
-  static float32x4_t add(float32x4_t& a, float32x4_t& b) {
-    return vaddq_f32(a, b);
-  }
-
-  static float32x4_t set(float& val) {
-    return vdupq_n_f32(val);
-  }
-
-  static float32x4_t mulAcc(float32x4_t& acc, float32x4_t& a, float32x4_t& b) {
-    return vmlaq_f32(acc, a, b);
-  }
-
-  static float32x4_t loadU(const float* buffer) {
-    return vld1q_f32(buffer);
-  }
-
-  static void storeU(float* buffer, float32x4_t& a) {
-    vst1q_f32(buffer, a);
-  }
-};
 
 //-----------------------------------
 
@@ -58,13 +22,22 @@ void dspInitNeon(FBDSP* d) {
   Internal::dspInit<float32x4_t>(d);
 }
 
-FBDSP::FBDSP() {
-  dspInitNeon(this);
+FBDSP::FBDSP(CPU::Tier tier) {
+  assert(CPU::tierSupported(tier));
+  if (tier == CPU::Tier::NEON) {
+    dspInitNeon(this);
+  } else {
+    Internal::dspInit<float>(this);
+  }
 }
 
 //-----------------------------------
 
-void FIR::process(const float* input, float* output, size_t numSamples) {
+FIR::ProcessFn FIR::processForTier(CPU::Tier tier) {
+  return tier == CPU::Tier::NEON ? &FIR::processNeon : &FIR::processScalar;
+}
+
+void FIR::processNeon(const float* input, float* output, size_t numSamples) {
   process<float32x4_t>(input, output, numSamples);
 }
 
@@ -73,4 +46,5 @@ void FIR::processAVX(const float*, float*, size_t) {
 }
 
 } // namespace TBE
+#endif // TBE_STATIC_ISA
 #endif // __ARM_NEON
@@ -0,0 +1,168 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "SeqLockSnapshot.hh"
+
+namespace TBE {
+/// How much of the real-time budget the calls seen by a DeadlineMonitor used. The load of a call
+/// is its processing time divided by the duration of the audio it produced.
+struct DeadlineStats {
+  /// The histogram has kBinsPerOctave bins per doubling of the load, from kMinLoad to kMaxLoad.
+  /// Bin 0 counts the calls below kMinLoad and the last bin the calls at kMaxLoad or above.
+  static constexpr int kBinsPerOctave = 4;
+  static constexpr int kMinLoadLog2 = -8;
+  static constexpr int kMaxLoadLog2 = 2;
+  static constexpr int kNumBins = (kMaxLoadLog2 - kMinLoadLog2) * kBinsPerOctave + 2;
+
+  uint64_t numCalls;
+  /// Calls that took longer than the audio they produced
+  uint64_t numOverruns;
+  uint64_t worstNs;
+  double worstLoad;
+  double sumLoad;
+  uint64_t histogram[kNumBins];
+
+  double getMeanLoad() const {
+    return numCalls > 0 ? sumLoad / numCalls : 0.0;
+  }
+
+  /// \return The lowest load counted in a bin. Bin 0 starts at 0
+  static double getBinLowerBound(int bin) {
+    assert(bin >= 0 && bin < kNumBins);
+    return bin == 0 ? 0.0 : std::exp2(kMinLoadLog2 + static_cast<double>(bin - 1) / kBinsPerOctave);
+  }
+
+  static int getBin(double load) {
+    if (!(load > 0.0)) {
+      return 0;
+    }
+    const double position = (std::log2(load) - kMinLoadLog2) * kBinsPerOctave;
+    if (position < 0.0) {
+      return 0;
+    }
+    return position >= kNumBins - 2 ? kNumBins - 1 : static_cast<int>(position) + 1;
+  }
+
+  /// \return The number of calls in the bins at or above the one holding load, e.g. to tell how
+  /// often a device got within 20% of glitching with getCallsAbove(0.8)
+  uint64_t getCallsAbove(double load) const {
+    uint64_t count = 0;
+    for (int bin = getBin(load); bin < kNumBins; ++bin) {
+      count += histogram[bin];
+    }
+    return count;
+  }
+};
+
+/// Measures each audio callback against its deadline, i.e. the duration of the samples it
+/// renders at the sample rate. Recording uses fixed memory, does not allocate or lock and is
+/// meant for the audio thread; getStats() may be polled by telemetry from any other thread.
+///
+///   monitor.begin();
+///   ... render numSamples ...
+///   monitor.end(numSamples);
+class DeadlineMonitor {
+ public:
+  /// \param sampleRate The sample rate of the audio being rendered. 0 disables the monitor
+  explicit DeadlineMonitor(float sampleRate = 0.f) {
+    setSampleRate(sampleRate);
+    memset(&stats_, 0, sizeof(stats_));
+  }
+
+  DeadlineMonitor(const DeadlineMonitor&) = delete;
+  DeadlineMonitor& operator=(const DeadlineMonitor&) = delete;
+
+  /// May be called from any thread. 0 disables the monitor
+  void setSampleRate(float sampleRate) {
+    assert(sampleRate >= 0.f);
+    sampleRate_.store(sampleRate, std::memory_order_relaxed);
+  }
+
+  float getSampleRate() const {
+    return sampleRate_.load(std::memory_order_relaxed);
+  }
+
+  bool isEnabled() const {
+    return getSampleRate() > 0.f;
+  }
+
+  /// \return The counters as of the last recorded call. Lock-free, may be called from any thread
+  DeadlineStats getStats() const {
+    return snapshot_.read();
+  }
+
+  /// Zero the counters when the next call is recorded. May be called from any thread
+  void reset() {
+    resetRequested_.store(true, std::memory_order_relaxed);
+  }
+
+  //
+  // Audio thread only
+  //
+
+  /// Start timing a call. Does nothing while disabled
+  void begin() {
+    start_ = isEnabled() ? now() : 0;
+  }
+
+  /// Stop timing the call started by begin() and record it
+  /// \param numSamples The number of samples per channel the call rendered
+  void end(int numSamples) {
+    if (start_ != 0) {
+      record(now() - start_, numSamples);
+      start_ = 0;
+    }
+  }
+
+  /// Record a call timed elsewhere
+  void record(uint64_t elapsedNs, int numSamples) {
+    const float sampleRate = getSampleRate();
+    if (sampleRate <= 0.f || numSamples <= 0) {
+      return;
+    }
+    if (resetRequested_.exchange(false, std::memory_order_relaxed)) {
+      memset(&stats_, 0, sizeof(stats_));
+    }
+
+    const double deadlineNs = 1e9 * numSamples / sampleRate;
+    const double load = elapsedNs / deadlineNs;
+    stats_.numCalls++;
+    stats_.numOverruns += load > 1.0 ? 1 : 0;
+    stats_.sumLoad += load;
+    if (load > stats_.worstLoad) {
+      stats_.worstLoad = load;
+    }
+    if (elapsedNs > stats_.worstNs) {
+      stats_.worstNs = elapsedNs;
+    }
+    stats_.histogram[DeadlineStats::getBin(load)]++;
+    snapshot_.publish(stats_);
+  }
+
+ private:
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  std::atomic<float> sampleRate_{0.f};
+  std::atomic<bool> resetRequested_{false};
+  uint64_t start_{0};
+  // Owned by the audio thread, copied to snapshot_ after each call
+  DeadlineStats stats_;
+  SeqLockSnapshot<DeadlineStats> snapshot_;
+};
+} // namespace TBE
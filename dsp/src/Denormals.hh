@@ -0,0 +1,139 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TBE_DENORMALS_X86 1
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define TBE_DENORMALS_AARCH64 1
+#elif defined(__arm__) && defined(__ARM_FP) && (defined(__GNUC__) || defined(__clang__))
+#define TBE_DENORMALS_ARM 1
+#endif
+
+namespace TBE {
+/// Sets the floating point unit of the calling thread to flush denormal results to zero (FTZ) and,
+/// on x86, to treat denormal inputs as zero (DAZ) for the lifetime of the object. The previous
+/// state is restored on destruction. Decaying IR tails and silence after a signal otherwise leave
+/// denormals in the FIR accumulators and delay lines, which are several times slower to process on
+/// x86. Typical use: { ScopedDenormalGuard guard; fir.process(in, out, n); }
+class ScopedDenormalGuard {
+ public:
+  /// \param enable Nothing is changed if false, so the guard can be toggled by a setting
+  explicit ScopedDenormalGuard(bool enable = true) {
+    if (!enable || !isSupported()) {
+      return;
+    }
+    active_ = true;
+    previous_ = readState();
+    const uintptr_t flushed = previous_ | kFlushBits;
+    // Nested guards find the flags already set and skip the (serialising) write
+    if (flushed != previous_) {
+      writeState(flushed);
+      restore_ = true;
+    }
+  }
+
+  ~ScopedDenormalGuard() {
+    if (restore_) {
+      writeState(previous_);
+    }
+  }
+
+  ScopedDenormalGuard(const ScopedDenormalGuard&) = delete;
+  ScopedDenormalGuard& operator=(const ScopedDenormalGuard&) = delete;
+
+  /// \return True if denormals are flushed while the guard is alive. If false the caller has to
+  /// fall back to flushDenormals() on its state
+  bool isActive() const {
+    return active_;
+  }
+
+  /// \return True if the platform has FTZ/DAZ flags this guard knows how to set
+  static bool isSupported() {
+#if defined(TBE_DENORMALS_X86) || defined(TBE_DENORMALS_AARCH64) || defined(TBE_DENORMALS_ARM)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+ private:
+#if defined(TBE_DENORMALS_X86)
+  // MXCSR flush to zero (bit 15) and denormals are zero (bit 6)
+  static const uintptr_t kFlushBits = 0x8040;
+
+  static uintptr_t readState() {
+    return _mm_getcsr();
+  }
+
+  static void writeState(uintptr_t state) {
+    _mm_setcsr(static_cast<unsigned int>(state));
+  }
+#elif defined(TBE_DENORMALS_AARCH64)
+  // FPCR flush to zero (bit 24), also applies to denormal inputs
+  static const uintptr_t kFlushBits = 1 << 24;
+
+  static uintptr_t readState() {
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    return static_cast<uintptr_t>(fpcr);
+  }
+
+  static void writeState(uintptr_t state) {
+    const uint64_t fpcr = state;
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+  }
+#elif defined(TBE_DENORMALS_ARM)
+  // FPSCR flush to zero (bit 24). NEON arithmetic always flushes, this covers VFP code
+  static const uintptr_t kFlushBits = 1 << 24;
+
+  static uintptr_t readState() {
+    uint32_t fpscr;
+    __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+    return fpscr;
+  }
+
+  static void writeState(uintptr_t state) {
+    const uint32_t fpscr = static_cast<uint32_t>(state);
+    __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+  }
+#else
+  static const uintptr_t kFlushBits = 0;
+
+  static uintptr_t readState() {
+    return 0;
+  }
+
+  static void writeState(uintptr_t) {}
+#endif
+
+  uintptr_t previous_{0};
+  bool active_{false};
+  bool restore_{false};
+};
+
+/// Fallback for platforms without FTZ/DAZ: set every denormal value of a buffer to zero. Cheap
+/// compared to a FIR, so it can be run over the filter state after each block.
+/// \param buffer Buffer to flush in place
+/// \param numOfSamples Number of samples in the buffer
+inline void flushDenormals(float* buffer, size_t numOfSamples) {
+  for (size_t i = 0; i < numOfSamples; ++i) {
+    uint32_t bits;
+    memcpy(&bits, buffer + i, sizeof(bits));
+    // A zero exponent with a non-zero mantissa is a denormal, zero stays zero either way
+    if ((bits & 0x7f800000u) == 0) {
+      buffer[i] = 0.f;
+    }
+  }
+}
+} // namespace TBE
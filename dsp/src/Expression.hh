@@ -0,0 +1,269 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include "RegOps.hh"
+
+namespace TBE {
+/// Compile time expression templates over RegOps. A chain of element-wise operations is built as a
+/// tree of small value types and evaluated in a single loop, with the intermediate results kept in
+/// registers instead of being written back to memory between the steps:
+///
+///   using namespace Expr;
+///   evaluate<__m128>(clip((Input(a) * gainA + Input(b)) * gainOut, -1.f, 1.f), output, n);
+///
+/// evaluate<TReg> must be instantiated where RegOps<TReg> is visible and the target ISA is
+/// enabled, e.g. in one of the DSP_*.cpp files. evaluate<float> runs the same tree without SIMD.
+namespace Expr {
+/// Base of every expression node, restricts the operators below to expressions
+template <typename TDerived>
+struct Node {
+  const TDerived& self() const {
+    return static_cast<const TDerived&>(*this);
+  }
+};
+
+/// A buffer read at the evaluated index
+class Input : public Node<Input> {
+ public:
+  explicit Input(const float* data) : data_(data) {}
+
+  template <typename TReg>
+  TReg eval(size_t i) const {
+    return RegOps<TReg>::loadU(data_ + i);
+  }
+
+  float evalScalar(size_t i) const {
+    return data_[i];
+  }
+
+ private:
+  const float* data_;
+};
+
+/// A value broadcast to every index
+class Constant : public Node<Constant> {
+ public:
+  explicit Constant(float value) : value_(value) {}
+
+  template <typename TReg>
+  TReg eval(size_t) const {
+    float value = value_;
+    return RegOps<TReg>::set(value);
+  }
+
+  float evalScalar(size_t) const {
+    return value_;
+  }
+
+ private:
+  float value_;
+};
+
+struct AddOp {
+  template <typename TReg>
+  static TReg applyReg(TReg& a, TReg& b) {
+    return RegOps<TReg>::add(a, b);
+  }
+  static float apply(float a, float b) {
+    return a + b;
+  }
+};
+
+struct SubOp {
+  template <typename TReg>
+  static TReg applyReg(TReg& a, TReg& b) {
+    return RegOps<TReg>::sub(a, b);
+  }
+  static float apply(float a, float b) {
+    return a - b;
+  }
+};
+
+struct MulOp {
+  template <typename TReg>
+  static TReg applyReg(TReg& a, TReg& b) {
+    return RegOps<TReg>::mul(a, b);
+  }
+  static float apply(float a, float b) {
+    return a * b;
+  }
+};
+
+struct MinOp {
+  template <typename TReg>
+  static TReg applyReg(TReg& a, TReg& b) {
+    return RegOps<TReg>::min(a, b);
+  }
+  static float apply(float a, float b) {
+    return std::min(a, b);
+  }
+};
+
+struct MaxOp {
+  template <typename TReg>
+  static TReg applyReg(TReg& a, TReg& b) {
+    return RegOps<TReg>::max(a, b);
+  }
+  static float apply(float a, float b) {
+    return std::max(a, b);
+  }
+};
+
+struct AbsOp {
+  template <typename TReg>
+  static TReg applyReg(TReg& a) {
+    return RegOps<TReg>::abs(a);
+  }
+  static float apply(float a) {
+    return std::abs(a);
+  }
+};
+
+template <typename TOp, typename TLeft, typename TRight>
+class Binary : public Node<Binary<TOp, TLeft, TRight>> {
+ public:
+  Binary(const TLeft& left, const TRight& right) : left_(left), right_(right) {}
+
+  template <typename TReg>
+  TReg eval(size_t i) const {
+    TReg a = left_.template eval<TReg>(i);
+    TReg b = right_.template eval<TReg>(i);
+    return TOp::template applyReg<TReg>(a, b);
+  }
+
+  float evalScalar(size_t i) const {
+    return TOp::apply(left_.evalScalar(i), right_.evalScalar(i));
+  }
+
+ private:
+  TLeft left_;
+  TRight right_;
+};
+
+template <typename TOp, typename TArg>
+class Unary : public Node<Unary<TOp, TArg>> {
+ public:
+  explicit Unary(const TArg& arg) : arg_(arg) {}
+
+  template <typename TReg>
+  TReg eval(size_t i) const {
+    TReg a = arg_.template eval<TReg>(i);
+    return TOp::template applyReg<TReg>(a);
+  }
+
+  float evalScalar(size_t i) const {
+    return TOp::apply(arg_.evalScalar(i));
+  }
+
+ private:
+  TArg arg_;
+};
+
+//
+// Operators. Plain floats on either side are wrapped in a Constant.
+//
+template <typename TLeft, typename TRight>
+Binary<AddOp, TLeft, TRight> operator+(const Node<TLeft>& left, const Node<TRight>& right) {
+  return {left.self(), right.self()};
+}
+
+template <typename TLeft>
+Binary<AddOp, TLeft, Constant> operator+(const Node<TLeft>& left, float right) {
+  return {left.self(), Constant(right)};
+}
+
+template <typename TRight>
+Binary<AddOp, Constant, TRight> operator+(float left, const Node<TRight>& right) {
+  return {Constant(left), right.self()};
+}
+
+template <typename TLeft, typename TRight>
+Binary<SubOp, TLeft, TRight> operator-(const Node<TLeft>& left, const Node<TRight>& right) {
+  return {left.self(), right.self()};
+}
+
+template <typename TLeft>
+Binary<SubOp, TLeft, Constant> operator-(const Node<TLeft>& left, float right) {
+  return {left.self(), Constant(right)};
+}
+
+template <typename TRight>
+Binary<SubOp, Constant, TRight> operator-(float left, const Node<TRight>& right) {
+  return {Constant(left), right.self()};
+}
+
+template <typename TLeft, typename TRight>
+Binary<MulOp, TLeft, TRight> operator*(const Node<TLeft>& left, const Node<TRight>& right) {
+  return {left.self(), right.self()};
+}
+
+template <typename TLeft>
+Binary<MulOp, TLeft, Constant> operator*(const Node<TLeft>& left, float right) {
+  return {left.self(), Constant(right)};
+}
+
+template <typename TRight>
+Binary<MulOp, Constant, TRight> operator*(float left, const Node<TRight>& right) {
+  return {Constant(left), right.self()};
+}
+
+template <typename TLeft, typename TRight>
+Binary<MinOp, TLeft, TRight> min(const Node<TLeft>& left, const Node<TRight>& right) {
+  return {left.self(), right.self()};
+}
+
+template <typename TLeft, typename TRight>
+Binary<MaxOp, TLeft, TRight> max(const Node<TLeft>& left, const Node<TRight>& right) {
+  return {left.self(), right.self()};
+}
+
+template <typename TArg>
+Unary<AbsOp, TArg> abs(const Node<TArg>& arg) {
+  return Unary<AbsOp, TArg>(arg.self());
+}
+
+/// Limit every value of an expression to [lo, hi]
+template <typename TArg>
+Binary<MinOp, Binary<MaxOp, TArg, Constant>, Constant>
+clip(const Node<TArg>& arg, float lo, float hi) {
+  return {Binary<MaxOp, TArg, Constant>(arg.self(), Constant(lo)), Constant(hi)};
+}
+
+template <typename TReg, typename TExpr>
+void evaluateImpl(const TExpr& expr, float* output, size_t numOfSamples, std::true_type) {
+  for (size_t i = 0; i < numOfSamples; ++i) {
+    output[i] = expr.evalScalar(i);
+  }
+}
+
+template <typename TReg, typename TExpr>
+void evaluateImpl(const TExpr& expr, float* output, size_t numOfSamples, std::false_type) {
+  const auto regWidth = RegOps<TReg>::width();
+  size_t i = 0;
+  TReg out;
+  for (; i + regWidth <= numOfSamples; i += regWidth) {
+    out = expr.template eval<TReg>(i);
+    RegOps<TReg>::storeU(output + i, out);
+  }
+  for (; i < numOfSamples; ++i) {
+    output[i] = expr.evalScalar(i);
+  }
+}
+
+/// Evaluate an expression for numOfSamples indices in a single pass and write the result to
+/// output. Each index is read before it is written, so output may be one of the inputs.
+template <typename TReg, typename TExpr>
+void evaluate(const Node<TExpr>& expr, float* output, size_t numOfSamples) {
+  evaluateImpl<TReg>(expr.self(), output, numOfSamples, std::is_same<TReg, float>());
+}
+} // namespace Expr
+} // namespace TBE
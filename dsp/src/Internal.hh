@@ -7,26 +7,56 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
-#include "DSP.hh"
+#include <limits>
+#include <string.h>
+#include "Expression.hh"
+#include "RegOps.hh"
 
 namespace TBE {
+static const float kLinear96dB = 0.000015848932f;
+
 namespace Internal {
+/// Widest register supported by any of the RegOps specialisations, in floats
+static const size_t kMaxRegWidth = 8;
+
+/// Register load and store of a kernel loop, aligned if every buffer of the call is
+template <typename TReg, bool kAligned>
+inline TReg loadReg(const float* buffer) {
+  return kAligned ? RegOps<TReg>::load(buffer) : RegOps<TReg>::loadU(buffer);
+}
+
+template <typename TReg, bool kAligned>
+inline void storeReg(float* buffer, TReg& a) {
+  kAligned ? RegOps<TReg>::store(buffer, a) : RegOps<TReg>::storeU(buffer, a);
+}
+
+/// \return True if all the buffers are aligned to the register width, e.g. the channels of an
+/// AudioBufferList
+template <typename TReg>
+inline bool isAligned(const float* a, const float* b = nullptr, const float* c = nullptr) {
+  const uintptr_t mask = RegOps<TReg>::width() * sizeof(float) - 1;
+  const uintptr_t addresses = reinterpret_cast<uintptr_t>(a) | reinterpret_cast<uintptr_t>(b) |
+      reinterpret_cast<uintptr_t>(c);
+  return (addresses & mask) == 0;
+}
+
 /// Multiply a buffer with a scalar value (output[i] = input[i] * scalar)
 /// \param input Input buffer
 /// \param scalar Scalar value
 /// \param output Output buffer where the result is written to
 /// \param numOfSamples Number of samples in the buffers
-template <typename TReg>
-void multiplyScalar(const float* input, float scalar, float* output, size_t numOfSamples) {
+template <typename TReg, bool kAligned>
+void multiplyScalarImpl(const float* input, float scalar, float* output, size_t numOfSamples) {
   const auto regWidth = RegOps<TReg>::width();
   size_t samplesLeft = numOfSamples;
   TReg in, out;
   while (samplesLeft >= regWidth) {
-    in = RegOps<TReg>::loadU(input);
+    in = loadReg<TReg, kAligned>(input);
     out = RegOps<TReg>::mul(in, scalar);
-    RegOps<TReg>::storeU(output, out);
+    storeReg<TReg, kAligned>(output, out);
     input += regWidth;
     output += regWidth;
     samplesLeft -= regWidth;
@@ -40,6 +70,15 @@ void multiplyScalar(const float* input, float scalar, float* output, size_t numO
   }
 }
 
+template <typename TReg>
+void multiplyScalar(const float* input, float scalar, float* output, size_t numOfSamples) {
+  if (isAligned<TReg>(input, output)) {
+    multiplyScalarImpl<TReg, true>(input, scalar, output, numOfSamples);
+  } else {
+    multiplyScalarImpl<TReg, false>(input, scalar, output, numOfSamples);
+  }
+}
+
 template <>
 inline void
 multiplyScalar<float>(const float* input, float scalar, float* output, size_t numOfSamples) {
@@ -53,16 +92,16 @@ multiplyScalar<float>(const float* input, float scalar, float* output, size_t nu
 /// \param inputB Input buffer B
 /// \param output Output buffer where the result is written to
 /// \param numOfSamples Number of samples in the buffers
-template <typename TReg>
-void multiply(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
+template <typename TReg, bool kAligned>
+void multiplyImpl(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
   const auto regWidth = RegOps<TReg>::width();
   size_t samplesLeft = numOfSamples;
   TReg inA, inB, out;
   while (samplesLeft >= regWidth) {
-    inA = RegOps<TReg>::loadU(inputA);
-    inB = RegOps<TReg>::loadU(inputB);
+    inA = loadReg<TReg, kAligned>(inputA);
+    inB = loadReg<TReg, kAligned>(inputB);
     out = RegOps<TReg>::mul(inA, inB);
-    RegOps<TReg>::storeU(output, out);
+    storeReg<TReg, kAligned>(output, out);
     inputA += regWidth;
     inputB += regWidth;
     output += regWidth;
@@ -78,6 +117,15 @@ void multiply(const float* inputA, const float* inputB, float* output, size_t nu
   }
 }
 
+template <typename TReg>
+void multiply(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
+  if (isAligned<TReg>(inputA, inputB, output)) {
+    multiplyImpl<TReg, true>(inputA, inputB, output, numOfSamples);
+  } else {
+    multiplyImpl<TReg, false>(inputA, inputB, output, numOfSamples);
+  }
+}
+
 template <>
 inline void
 multiply<float>(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
@@ -91,16 +139,16 @@ multiply<float>(const float* inputA, const float* inputB, float* output, size_t
 /// \param scalar Scalar value
 /// \param output Output buffer where the result is written to
 /// \param numOfSamples Number of samples in the buffers
-template <typename TReg>
-void addScalar(const float* input, float scalar, float* output, size_t numOfSamples) {
+template <typename TReg, bool kAligned>
+void addScalarImpl(const float* input, float scalar, float* output, size_t numOfSamples) {
   const auto regWidth = RegOps<TReg>::width();
   size_t samplesLeft = numOfSamples;
   TReg in, s, out;
   while (samplesLeft >= regWidth) {
-    in = RegOps<TReg>::loadU(input);
+    in = loadReg<TReg, kAligned>(input);
     s = RegOps<TReg>::set(scalar);
     out = RegOps<TReg>::add(in, s);
-    RegOps<TReg>::storeU(output, out);
+    storeReg<TReg, kAligned>(output, out);
     input += regWidth;
     output += regWidth;
     samplesLeft -= regWidth;
@@ -114,6 +162,15 @@ void addScalar(const float* input, float scalar, float* output, size_t numOfSamp
   }
 }
 
+template <typename TReg>
+void addScalar(const float* input, float scalar, float* output, size_t numOfSamples) {
+  if (isAligned<TReg>(input, output)) {
+    addScalarImpl<TReg, true>(input, scalar, output, numOfSamples);
+  } else {
+    addScalarImpl<TReg, false>(input, scalar, output, numOfSamples);
+  }
+}
+
 template <>
 inline void addScalar<float>(const float* input, float scalar, float* output, size_t numOfSamples) {
   while (numOfSamples--) {
@@ -126,16 +183,16 @@ inline void addScalar<float>(const float* input, float scalar, float* output, si
 /// \param inputB Input buffer B
 /// \param output Output buffer where the result is written to
 /// \param numOfSamples Number of samples in the buffers
-template <typename TReg>
-void add(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
+template <typename TReg, bool kAligned>
+void addImpl(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
   const auto regWidth = RegOps<TReg>::width();
   size_t samplesLeft = numOfSamples;
   TReg inA, inB, out;
   while (samplesLeft >= regWidth) {
-    inA = RegOps<TReg>::loadU(inputA);
-    inB = RegOps<TReg>::loadU(inputB);
+    inA = loadReg<TReg, kAligned>(inputA);
+    inB = loadReg<TReg, kAligned>(inputB);
     out = RegOps<TReg>::add(inA, inB);
-    RegOps<TReg>::storeU(output, out);
+    storeReg<TReg, kAligned>(output, out);
     inputA += regWidth;
     inputB += regWidth;
     output += regWidth;
@@ -151,6 +208,15 @@ void add(const float* inputA, const float* inputB, float* output, size_t numOfSa
   }
 }
 
+template <typename TReg>
+void add(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
+  if (isAligned<TReg>(inputA, inputB, output)) {
+    addImpl<TReg, true>(inputA, inputB, output, numOfSamples);
+  } else {
+    addImpl<TReg, false>(inputA, inputB, output, numOfSamples);
+  }
+}
+
 template <>
 inline void
 add<float>(const float* inputA, const float* inputB, float* output, size_t numOfSamples) {
@@ -164,8 +230,8 @@ add<float>(const float* inputA, const float* inputB, float* output, size_t numOf
 /// to inputToScale \param bufferToAdd Buffer to add to inputToScale after it is scaled \param
 /// output Output buffer where the result is written to \param numOfSamples Number of samples in the
 /// buffers
-template <typename TReg>
-void multiplyInputAndAdd(
+template <typename TReg, bool kAligned>
+void multiplyInputAndAddImpl(
     const float* inputToScale,
     float scalar,
     const float* bufferToAdd,
@@ -175,15 +241,15 @@ void multiplyInputAndAdd(
   size_t samplesLeft = numOfSamples;
   TReg inToScale, bufferAdd, scalar_vec, scaledInput, summed;
   while (samplesLeft >= regWidth) {
-    inToScale = RegOps<TReg>::loadU(inputToScale);
-    bufferAdd = RegOps<TReg>::loadU(bufferToAdd);
+    inToScale = loadReg<TReg, kAligned>(inputToScale);
+    bufferAdd = loadReg<TReg, kAligned>(bufferToAdd);
 
     scalar_vec = RegOps<TReg>::set(scalar);
     scaledInput = RegOps<TReg>::mul(inToScale, scalar_vec);
 
     summed = RegOps<TReg>::add(scaledInput, bufferAdd);
 
-    RegOps<TReg>::storeU(output, summed);
+    storeReg<TReg, kAligned>(output, summed);
     inputToScale += regWidth;
     bufferToAdd += regWidth;
     output += regWidth;
@@ -199,6 +265,20 @@ void multiplyInputAndAdd(
   }
 }
 
+template <typename TReg>
+void multiplyInputAndAdd(
+    const float* inputToScale,
+    float scalar,
+    const float* bufferToAdd,
+    float* output,
+    size_t numOfSamples) {
+  if (isAligned<TReg>(inputToScale, bufferToAdd, output)) {
+    multiplyInputAndAddImpl<TReg, true>(inputToScale, scalar, bufferToAdd, output, numOfSamples);
+  } else {
+    multiplyInputAndAddImpl<TReg, false>(inputToScale, scalar, bufferToAdd, output, numOfSamples);
+  }
+}
+
 template <>
 inline void multiplyInputAndAdd<float>(
     const float* inputToScale,
@@ -211,16 +291,1129 @@ inline void multiplyInputAndAdd<float>(
   }
 }
 
+/// Shared implementation of the ramped gain kernels: output[i] = input[i] * gain(i) (+ add[i]).
+/// With kExponential the gain follows startGain * (endGain / startGain)^(i / numOfSamples),
+/// otherwise startGain + (endGain - startGain) * i / numOfSamples. The gain of every lane is kept
+/// in a register and advanced by a single add or multiply per vector.
+template <typename TReg, bool kExponential, bool kAdd>
+void rampImpl(
+    const float* input,
+    float startGain,
+    float endGain,
+    const float* bufferToAdd,
+    float* output,
+    size_t numOfSamples) {
+  if (numOfSamples == 0) {
+    return;
+  }
+
+  const auto regWidth = RegOps<TReg>::width();
+  const float n = static_cast<float>(numOfSamples);
+  const float increment = kExponential ? std::pow(endGain / startGain, 1.f / n)
+                                       : (endGain - startGain) / n;
+
+  float lanes[kMaxRegWidth];
+  for (size_t k = 0; k < regWidth; ++k) {
+    lanes[k] = kExponential ? startGain * std::pow(increment, static_cast<float>(k))
+                            : startGain + increment * static_cast<float>(k);
+  }
+  float vectorIncrement = kExponential ? std::pow(increment, static_cast<float>(regWidth))
+                                       : increment * static_cast<float>(regWidth);
+
+  TReg gain = RegOps<TReg>::loadU(lanes);
+  TReg step = RegOps<TReg>::set(vectorIncrement);
+  TReg in, add, out;
+
+  size_t samplesLeft = numOfSamples;
+  while (samplesLeft >= regWidth) {
+    in = RegOps<TReg>::loadU(input);
+    if (kAdd) {
+      add = RegOps<TReg>::loadU(bufferToAdd);
+      out = RegOps<TReg>::mulAcc(add, in, gain);
+      bufferToAdd += regWidth;
+    } else {
+      out = RegOps<TReg>::mul(in, gain);
+    }
+    RegOps<TReg>::storeU(output, out);
+    gain = kExponential ? RegOps<TReg>::mul(gain, step) : RegOps<TReg>::add(gain, step);
+    input += regWidth;
+    output += regWidth;
+    samplesLeft -= regWidth;
+  }
+
+  float g = kExponential
+      ? startGain * std::pow(increment, static_cast<float>(numOfSamples - samplesLeft))
+      : startGain + increment * static_cast<float>(numOfSamples - samplesLeft);
+  while (samplesLeft) {
+    *output = kAdd ? (*input * g) + *bufferToAdd++ : *input * g;
+    g = kExponential ? g * increment : g + increment;
+    output++;
+    input++;
+    samplesLeft--;
+  }
+}
+
+template <bool kExponential, bool kAdd>
+inline void rampScalar(
+    const float* input,
+    float startGain,
+    float endGain,
+    const float* bufferToAdd,
+    float* output,
+    size_t numOfSamples) {
+  const float n = static_cast<float>(numOfSamples);
+  const float increment = kExponential ? std::pow(endGain / startGain, 1.f / n)
+                                       : (endGain - startGain) / n;
+  float g = startGain;
+  while (numOfSamples--) {
+    *output++ = kAdd ? (*input++ * g) + *bufferToAdd++ : *input++ * g;
+    g = kExponential ? g * increment : g + increment;
+  }
+}
+
+/// Multiply a buffer with a linearly ramped gain
+/// (output[i] = input[i] * (startGain + (endGain - startGain) * i / numOfSamples))
 template <typename TReg>
-bool isBufferSilent(const float* input, size_t numOfSamples) {
+void multiplyRamp(
+    const float* input,
+    float startGain,
+    float endGain,
+    float* output,
+    size_t numOfSamples) {
+  rampImpl<TReg, false, false>(input, startGain, endGain, nullptr, output, numOfSamples);
+}
+
+template <>
+inline void multiplyRamp<float>(
+    const float* input,
+    float startGain,
+    float endGain,
+    float* output,
+    size_t numOfSamples) {
+  rampScalar<false, false>(input, startGain, endGain, nullptr, output, numOfSamples);
+}
+
+/// Multiply a buffer with an exponentially ramped gain
+/// (output[i] = input[i] * startGain * (endGain / startGain)^(i / numOfSamples))
+template <typename TReg>
+void multiplyRampExp(
+    const float* input,
+    float startGain,
+    float endGain,
+    float* output,
+    size_t numOfSamples) {
+  assert(startGain * endGain > 0.f);
+  rampImpl<TReg, true, false>(input, startGain, endGain, nullptr, output, numOfSamples);
+}
+
+template <>
+inline void multiplyRampExp<float>(
+    const float* input,
+    float startGain,
+    float endGain,
+    float* output,
+    size_t numOfSamples) {
+  assert(startGain * endGain > 0.f);
+  rampScalar<true, false>(input, startGain, endGain, nullptr, output, numOfSamples);
+}
+
+/// Multiply the input buffer with a linearly ramped gain and then sum the result with another
+/// buffer (output[i] = input[i] * (startGain + (endGain - startGain) * i / numOfSamples) + b[i])
+template <typename TReg>
+void multiplyRampAndAdd(
+    const float* inputToScale,
+    float startGain,
+    float endGain,
+    const float* bufferToAdd,
+    float* output,
+    size_t numOfSamples) {
+  rampImpl<TReg, false, true>(inputToScale, startGain, endGain, bufferToAdd, output, numOfSamples);
+}
+
+template <>
+inline void multiplyRampAndAdd<float>(
+    const float* inputToScale,
+    float startGain,
+    float endGain,
+    const float* bufferToAdd,
+    float* output,
+    size_t numOfSamples) {
+  rampScalar<false, true>(inputToScale, startGain, endGain, bufferToAdd, output, numOfSamples);
+}
+
+/// Multiply the input buffer with an exponentially ramped gain and then sum the result with
+/// another buffer (output[i] = input[i] * startGain * (endGain / startGain)^(i / numOfSamples) +
+/// b[i])
+template <typename TReg>
+void multiplyRampExpAndAdd(
+    const float* inputToScale,
+    float startGain,
+    float endGain,
+    const float* bufferToAdd,
+    float* output,
+    size_t numOfSamples) {
+  assert(startGain * endGain > 0.f);
+  rampImpl<TReg, true, true>(inputToScale, startGain, endGain, bufferToAdd, output, numOfSamples);
+}
+
+template <>
+inline void multiplyRampExpAndAdd<float>(
+    const float* inputToScale,
+    float startGain,
+    float endGain,
+    const float* bufferToAdd,
+    float* output,
+    size_t numOfSamples) {
+  assert(startGain * endGain > 0.f);
+  rampScalar<true, true>(inputToScale, startGain, endGain, bufferToAdd, output, numOfSamples);
+}
+
+/// Number of independent accumulators the reductions are unrolled over, hiding the latency of the
+/// dependent add / max chains
+static const size_t kReduceAccumulators = 4;
+
+/// Reduction operations for reduce(). Each provides the identity, the per element step for
+/// registers and scalars and how two partial results are combined.
+struct PeakOp {
+  static float identity() {
+    return 0.f;
+  }
+  template <typename TReg>
+  static TReg stepReg(TReg& acc, TReg& a, TReg&) {
+    TReg absA = RegOps<TReg>::abs(a);
+    return RegOps<TReg>::maxNaN(acc, absA);
+  }
+  template <typename TReg>
+  static TReg combineReg(TReg& a, TReg& b) {
+    return RegOps<TReg>::maxNaN(a, b);
+  }
+  static float step(float acc, float a, float) {
+    return combine(acc, std::abs(a));
+  }
+  // NaN wins, so a buffer holding one doesn't pass for silent
+  static float combine(float a, float b) {
+    if (a != a || b != b) {
+      return a + b;
+    }
+    return std::max(a, b);
+  }
+};
+
+struct SumOp {
+  static float identity() {
+    return 0.f;
+  }
+  template <typename TReg>
+  static TReg stepReg(TReg& acc, TReg& a, TReg&) {
+    return RegOps<TReg>::add(acc, a);
+  }
+  template <typename TReg>
+  static TReg combineReg(TReg& a, TReg& b) {
+    return RegOps<TReg>::add(a, b);
+  }
+  static float step(float acc, float a, float) {
+    return acc + a;
+  }
+  static float combine(float a, float b) {
+    return a + b;
+  }
+};
+
+struct SumOfSquaresOp : SumOp {
+  template <typename TReg>
+  static TReg stepReg(TReg& acc, TReg& a, TReg&) {
+    return RegOps<TReg>::mulAcc(acc, a, a);
+  }
+  static float step(float acc, float a, float) {
+    return acc + a * a;
+  }
+};
+
+struct DotProductOp : SumOp {
+  template <typename TReg>
+  static TReg stepReg(TReg& acc, TReg& a, TReg& b) {
+    return RegOps<TReg>::mulAcc(acc, a, b);
+  }
+  static float step(float acc, float a, float b) {
+    return acc + a * b;
+  }
+};
+
+/// Reduce one (or two for TOp = DotProductOp) buffers to a single value using
+/// kReduceAccumulators independent register accumulators
+template <typename TReg, typename TOp, bool kTwoInputs>
+float reduce(const float* inputA, const float* inputB, size_t numOfSamples) {
+  const auto regWidth = RegOps<TReg>::width();
+  const size_t unrolled = kReduceAccumulators * regWidth;
+  float identity = TOp::identity();
+  TReg acc[kReduceAccumulators];
+  TReg a, b;
+  for (size_t k = 0; k < kReduceAccumulators; ++k) {
+    acc[k] = RegOps<TReg>::set(identity);
+  }
+
+  size_t samplesLeft = numOfSamples;
+  while (samplesLeft >= unrolled) {
+    for (size_t k = 0; k < kReduceAccumulators; ++k) {
+      a = RegOps<TReg>::loadU(inputA + k * regWidth);
+      b = kTwoInputs ? RegOps<TReg>::loadU(inputB + k * regWidth) : a;
+      acc[k] = TOp::stepReg(acc[k], a, b);
+    }
+    inputA += unrolled;
+    inputB += kTwoInputs ? unrolled : 0;
+    samplesLeft -= unrolled;
+  }
+
+  while (samplesLeft >= regWidth) {
+    a = RegOps<TReg>::loadU(inputA);
+    b = kTwoInputs ? RegOps<TReg>::loadU(inputB) : a;
+    acc[0] = TOp::stepReg(acc[0], a, b);
+    inputA += regWidth;
+    inputB += kTwoInputs ? regWidth : 0;
+    samplesLeft -= regWidth;
+  }
+
+  for (size_t k = 1; k < kReduceAccumulators; ++k) {
+    acc[0] = TOp::combineReg(acc[0], acc[k]);
+  }
+
+  float lanes[kMaxRegWidth];
+  RegOps<TReg>::storeU(lanes, acc[0]);
+  float result = lanes[0];
+  for (size_t k = 1; k < regWidth; ++k) {
+    result = TOp::combine(result, lanes[k]);
+  }
+
+  while (samplesLeft--) {
+    result = TOp::step(result, *inputA++, kTwoInputs ? *inputB++ : 0.f);
+  }
+  return result;
+}
+
+template <typename TOp, bool kTwoInputs>
+inline float reduceScalar(const float* inputA, const float* inputB, size_t numOfSamples) {
+  float result = TOp::identity();
+  while (numOfSamples--) {
+    result = TOp::step(result, *inputA++, kTwoInputs ? *inputB++ : 0.f);
+  }
+  return result;
+}
+
+/// Largest absolute value in a buffer
+template <typename TReg>
+float peak(const float* input, size_t numOfSamples) {
+  return reduce<TReg, PeakOp, false>(input, nullptr, numOfSamples);
+}
+
+template <>
+inline float peak<float>(const float* input, size_t numOfSamples) {
+  return reduceScalar<PeakOp, false>(input, nullptr, numOfSamples);
+}
+
+/// Sum of all the values in a buffer
+template <typename TReg>
+float sum(const float* input, size_t numOfSamples) {
+  return reduce<TReg, SumOp, false>(input, nullptr, numOfSamples);
+}
+
+template <>
+inline float sum<float>(const float* input, size_t numOfSamples) {
+  return reduceScalar<SumOp, false>(input, nullptr, numOfSamples);
+}
+
+/// Sum of the squared values in a buffer (its energy)
+template <typename TReg>
+float sumOfSquares(const float* input, size_t numOfSamples) {
+  return reduce<TReg, SumOfSquaresOp, false>(input, nullptr, numOfSamples);
+}
+
+template <>
+inline float sumOfSquares<float>(const float* input, size_t numOfSamples) {
+  return reduceScalar<SumOfSquaresOp, false>(input, nullptr, numOfSamples);
+}
+
+/// Sum of the element-wise product of two buffers
+template <typename TReg>
+float dotProduct(const float* inputA, const float* inputB, size_t numOfSamples) {
+  return reduce<TReg, DotProductOp, true>(inputA, inputB, numOfSamples);
+}
+
+template <>
+inline float dotProduct<float>(const float* inputA, const float* inputB, size_t numOfSamples) {
+  return reduceScalar<DotProductOp, true>(inputA, inputB, numOfSamples);
+}
+
+/// Smallest and largest values in a buffer, found in a single pass
+template <typename TReg>
+void minMax(const float* input, size_t numOfSamples, float* minValue, float* maxValue) {
+  assert(minValue && maxValue);
+  const auto regWidth = RegOps<TReg>::width();
+  const size_t unrolled = 2 * regWidth;
+  float lowest = std::numeric_limits<float>::infinity();
+  float highest = -lowest;
+  TReg min0 = RegOps<TReg>::set(lowest);
+  TReg min1 = min0;
+  TReg max0 = RegOps<TReg>::set(highest);
+  TReg max1 = max0;
+  TReg in0, in1;
+
+  size_t samplesLeft = numOfSamples;
+  while (samplesLeft >= unrolled) {
+    in0 = RegOps<TReg>::loadU(input);
+    in1 = RegOps<TReg>::loadU(input + regWidth);
+    min0 = RegOps<TReg>::min(min0, in0);
+    min1 = RegOps<TReg>::min(min1, in1);
+    max0 = RegOps<TReg>::max(max0, in0);
+    max1 = RegOps<TReg>::max(max1, in1);
+    input += unrolled;
+    samplesLeft -= unrolled;
+  }
+
+  while (samplesLeft >= regWidth) {
+    in0 = RegOps<TReg>::loadU(input);
+    min0 = RegOps<TReg>::min(min0, in0);
+    max0 = RegOps<TReg>::max(max0, in0);
+    input += regWidth;
+    samplesLeft -= regWidth;
+  }
+
+  min0 = RegOps<TReg>::min(min0, min1);
+  max0 = RegOps<TReg>::max(max0, max1);
+
+  float minLanes[kMaxRegWidth];
+  float maxLanes[kMaxRegWidth];
+  RegOps<TReg>::storeU(minLanes, min0);
+  RegOps<TReg>::storeU(maxLanes, max0);
+  float lo = minLanes[0];
+  float hi = maxLanes[0];
+  for (size_t k = 1; k < regWidth; ++k) {
+    lo = std::min(lo, minLanes[k]);
+    hi = std::max(hi, maxLanes[k]);
+  }
+
+  while (samplesLeft--) {
+    lo = std::min(lo, *input);
+    hi = std::max(hi, *input);
+    input++;
+  }
+  *minValue = lo;
+  *maxValue = hi;
+}
+
+template <>
+inline void
+minMax<float>(const float* input, size_t numOfSamples, float* minValue, float* maxValue) {
+  assert(minValue && maxValue);
+  float lo = std::numeric_limits<float>::infinity();
+  float hi = -lo;
   while (numOfSamples--) {
-    if (std::abs(*input++) > kLinear96dB) {
+    lo = std::min(lo, *input);
+    hi = std::max(hi, *input);
+    input++;
+  }
+  *minValue = lo;
+  *maxValue = hi;
+}
+
+/// Samples searched between each early exit check of isBufferSilent
+static const size_t kSilenceSearchBlock = 64;
+
+template <typename TReg>
+bool isBufferSilent(const float* input, size_t numOfSamples) {
+  while (numOfSamples) {
+    const size_t len = std::min(numOfSamples, kSilenceSearchBlock);
+    if (peak<TReg>(input, len) > kLinear96dB) {
       return false;
     }
+    input += len;
+    numOfSamples -= len;
   }
   return true;
 }
 
+/// Outputs of the matrix mix kernels are processed in groups of kMatrixMixOutputsPerPass so that
+/// every input vector loaded is reused for several accumulators before moving on.
+static const size_t kMatrixMixOutputsPerPass = 4;
+
+/// Process kNumOutputs rows of a row-major gain matrix in one pass over the inputs.
+/// When kAccumulate is set the result is added to the outputs instead of overwriting them.
+template <typename TReg, size_t kNumOutputs, bool kAccumulate>
+void matrixMixPass(
+    const float** inputs,
+    size_t numInputs,
+    const float* gains,
+    float** outputs,
+    size_t numOfSamples) {
+  const auto regWidth = RegOps<TReg>::width();
+  TReg in, g, acc[kNumOutputs];
+
+  size_t n = 0;
+  for (; n + regWidth <= numOfSamples; n += regWidth) {
+    for (size_t j = 0; j < kNumOutputs; ++j) {
+      acc[j] = kAccumulate ? RegOps<TReg>::loadU(outputs[j] + n) : RegOps<TReg>::zero();
+    }
+    for (size_t i = 0; i < numInputs; ++i) {
+      in = RegOps<TReg>::loadU(inputs[i] + n);
+      for (size_t j = 0; j < kNumOutputs; ++j) {
+        float gain = gains[j * numInputs + i];
+        g = RegOps<TReg>::set(gain);
+        acc[j] = RegOps<TReg>::mulAcc(acc[j], in, g);
+      }
+    }
+    for (size_t j = 0; j < kNumOutputs; ++j) {
+      RegOps<TReg>::storeU(outputs[j] + n, acc[j]);
+    }
+  }
+
+  for (; n < numOfSamples; ++n) {
+    float sum[kNumOutputs];
+    for (size_t j = 0; j < kNumOutputs; ++j) {
+      sum[j] = kAccumulate ? outputs[j][n] : 0.f;
+    }
+    for (size_t i = 0; i < numInputs; ++i) {
+      const float x = inputs[i][n];
+      for (size_t j = 0; j < kNumOutputs; ++j) {
+        sum[j] += gains[j * numInputs + i] * x;
+      }
+    }
+    for (size_t j = 0; j < kNumOutputs; ++j) {
+      outputs[j][n] = sum[j];
+    }
+  }
+}
+
+template <typename TReg, bool kAccumulate>
+void matrixMixImpl(
+    const float** inputs,
+    size_t numInputs,
+    const float* gains,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples) {
+  // Whole passes, counted up front: stepping past numOutputs is then impossible, which GCC can't
+  // tell from a running bound when the loops are inlined with a constant numOutputs
+  const size_t numFullOutputs = numOutputs - numOutputs % kMatrixMixOutputsPerPass;
+  for (size_t out = 0; out < numFullOutputs; out += kMatrixMixOutputsPerPass) {
+    matrixMixPass<TReg, kMatrixMixOutputsPerPass, kAccumulate>(
+        inputs, numInputs, gains + out * numInputs, outputs + out, numOfSamples);
+  }
+
+  // Remaining outputs that don't fill a whole pass
+  for (size_t out = numFullOutputs; out < numOutputs; ++out) {
+    matrixMixPass<TReg, 1, kAccumulate>(
+        inputs, numInputs, gains + out * numInputs, outputs + out, numOfSamples);
+  }
+}
+
+inline void matrixMixScalar(
+    const float** inputs,
+    size_t numInputs,
+    const float* gains,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples,
+    bool accumulate) {
+  for (size_t out = 0; out < numOutputs; ++out) {
+    const float* g = gains + out * numInputs;
+    for (size_t n = 0; n < numOfSamples; ++n) {
+      float sum = accumulate ? outputs[out][n] : 0.f;
+      for (size_t i = 0; i < numInputs; ++i) {
+        sum += g[i] * inputs[i][n];
+      }
+      outputs[out][n] = sum;
+    }
+  }
+}
+
+/// Mix a set of input buffers into a set of output buffers through a row-major gain matrix
+/// (outputs[j][n] = sum over i of gains[j * numInputs + i] * inputs[i][n])
+template <typename TReg>
+void matrixMix(
+    const float** inputs,
+    size_t numInputs,
+    const float* gains,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples) {
+  matrixMixImpl<TReg, false>(inputs, numInputs, gains, outputs, numOutputs, numOfSamples);
+}
+
+template <>
+inline void matrixMix<float>(
+    const float** inputs,
+    size_t numInputs,
+    const float* gains,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples) {
+  matrixMixScalar(inputs, numInputs, gains, outputs, numOutputs, numOfSamples, false);
+}
+
+/// Mix a set of input buffers through a row-major gain matrix and add the result to the outputs
+/// (outputs[j][n] += sum over i of gains[j * numInputs + i] * inputs[i][n])
+template <typename TReg>
+void matrixMixAdd(
+    const float** inputs,
+    size_t numInputs,
+    const float* gains,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples) {
+  matrixMixImpl<TReg, true>(inputs, numInputs, gains, outputs, numOutputs, numOfSamples);
+}
+
+template <>
+inline void matrixMixAdd<float>(
+    const float** inputs,
+    size_t numInputs,
+    const float* gains,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples) {
+  matrixMixScalar(inputs, numInputs, gains, outputs, numOutputs, numOfSamples, true);
+}
+
+/// Mix channels through a block-diagonal gain matrix, such as an Ambisonic rotation. Block b maps
+/// blockSizes[b] consecutive input channels to the same output channels and its square row-major
+/// matrix follows the one of block b - 1 in gains.
+template <typename TReg>
+void matrixMixBlockDiagonal(
+    const float** inputs,
+    const float* gains,
+    const size_t* blockSizes,
+    size_t numBlocks,
+    float** outputs,
+    size_t numOfSamples) {
+  for (size_t b = 0; b < numBlocks; ++b) {
+    const size_t size = blockSizes[b];
+    matrixMix<TReg>(inputs, size, gains, outputs, size, numOfSamples);
+    inputs += size;
+    outputs += size;
+    gains += size * size;
+  }
+}
+
+/// Process kNumOutputs rows of two row-major gain matrices in one pass over the inputs, the gains
+/// being linearly interpolated from gainsStart to gainsEnd sample by sample.
+template <typename TReg, size_t kNumOutputs>
+void matrixMixInterpolatedPass(
+    const float** inputs,
+    size_t numInputs,
+    const float* gainsStart,
+    const float* gainsEnd,
+    float** outputs,
+    size_t numOfSamples) {
+  const auto regWidth = RegOps<TReg>::width();
+  const float step = 1.f / static_cast<float>(numOfSamples);
+  TReg in, g, gStart, gDelta, t, tOffset, acc[kNumOutputs];
+
+  // Interpolation position of every lane of the first vector
+  float lanes[kMaxRegWidth];
+  for (size_t k = 0; k < regWidth; ++k) {
+    lanes[k] = static_cast<float>(k) * step;
+  }
+  const TReg tLanes = RegOps<TReg>::loadU(lanes);
+
+  size_t n = 0;
+  for (; n + regWidth <= numOfSamples; n += regWidth) {
+    float offset = static_cast<float>(n) * step;
+    tOffset = RegOps<TReg>::set(offset);
+    t = tLanes;
+    t = RegOps<TReg>::add(t, tOffset);
+
+    for (size_t j = 0; j < kNumOutputs; ++j) {
+      acc[j] = RegOps<TReg>::zero();
+    }
+    for (size_t i = 0; i < numInputs; ++i) {
+      in = RegOps<TReg>::loadU(inputs[i] + n);
+      for (size_t j = 0; j < kNumOutputs; ++j) {
+        float start = gainsStart[j * numInputs + i];
+        float delta = gainsEnd[j * numInputs + i] - start;
+        gStart = RegOps<TReg>::set(start);
+        gDelta = RegOps<TReg>::set(delta);
+        g = RegOps<TReg>::mulAcc(gStart, gDelta, t);
+        acc[j] = RegOps<TReg>::mulAcc(acc[j], in, g);
+      }
+    }
+    for (size_t j = 0; j < kNumOutputs; ++j) {
+      RegOps<TReg>::storeU(outputs[j] + n, acc[j]);
+    }
+  }
+
+  for (; n < numOfSamples; ++n) {
+    const float pos = static_cast<float>(n) * step;
+    for (size_t j = 0; j < kNumOutputs; ++j) {
+      float sum = 0.f;
+      for (size_t i = 0; i < numInputs; ++i) {
+        const float start = gainsStart[j * numInputs + i];
+        const float gain = start + (gainsEnd[j * numInputs + i] - start) * pos;
+        sum += gain * inputs[i][n];
+      }
+      outputs[j][n] = sum;
+    }
+  }
+}
+
+/// Mix a set of input buffers into a set of output buffers through a gain matrix that is linearly
+/// interpolated sample by sample from gainsStart (first sample) towards gainsEnd, which is reached
+/// on the first sample after the buffer. Consecutive buffers therefore join without a step.
+template <typename TReg>
+void matrixMixInterpolated(
+    const float** inputs,
+    size_t numInputs,
+    const float* gainsStart,
+    const float* gainsEnd,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples) {
+  if (numOfSamples == 0) {
+    return;
+  }
+
+  // Whole passes first, see matrixMixImpl
+  const size_t numFullOutputs = numOutputs - numOutputs % kMatrixMixOutputsPerPass;
+  for (size_t out = 0; out < numFullOutputs; out += kMatrixMixOutputsPerPass) {
+    matrixMixInterpolatedPass<TReg, kMatrixMixOutputsPerPass>(
+        inputs,
+        numInputs,
+        gainsStart + out * numInputs,
+        gainsEnd + out * numInputs,
+        outputs + out,
+        numOfSamples);
+  }
+
+  for (size_t out = numFullOutputs; out < numOutputs; ++out) {
+    matrixMixInterpolatedPass<TReg, 1>(
+        inputs,
+        numInputs,
+        gainsStart + out * numInputs,
+        gainsEnd + out * numInputs,
+        outputs + out,
+        numOfSamples);
+  }
+}
+
+template <>
+inline void matrixMixInterpolated<float>(
+    const float** inputs,
+    size_t numInputs,
+    const float* gainsStart,
+    const float* gainsEnd,
+    float** outputs,
+    size_t numOutputs,
+    size_t numOfSamples) {
+  const float step = numOfSamples ? 1.f / static_cast<float>(numOfSamples) : 0.f;
+  for (size_t out = 0; out < numOutputs; ++out) {
+    for (size_t n = 0; n < numOfSamples; ++n) {
+      const float pos = static_cast<float>(n) * step;
+      float sum = 0.f;
+      for (size_t i = 0; i < numInputs; ++i) {
+        const float start = gainsStart[out * numInputs + i];
+        const float gain = start + (gainsEnd[out * numInputs + i] - start) * pos;
+        sum += gain * inputs[i][n];
+      }
+      outputs[out][n] = sum;
+    }
+  }
+}
+
+/// Full scale of the integer sample formats
+static const float kInt16Scale = 32768.f;
+static const float kInt24Scale = 8388608.f;
+static const float kInt32Scale = 2147483648.f;
+/// Largest float that still converts to a valid int32
+static const float kInt32MaxAsFloat = 2147483520.f;
+/// The 24 bit conversions go through an int32 buffer of this many samples on the stack
+static const size_t kConvertChunk = 64;
+
+/// Triangular (TPDF) dither in (-1, 1) LSB, the difference of two uniform values drawn from a
+/// xorshift32 generator whose state is kept by the caller
+inline float tpdfDither(uint32_t& state) {
+  if (state == 0) {
+    state = 0x9E3779B9u; // xorshift must not start from zero
+  }
+  const float kToUnit = 1.f / 16777216.f;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  const float r1 = static_cast<float>(state >> 8) * kToUnit;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  const float r2 = static_cast<float>(state >> 8) * kToUnit;
+  return r1 - r2;
+}
+
+/// Scale, dither and clamp a float sample to the range of an integer format, rounding to nearest.
+/// NaN converts to 0, silence rather than a full scale click.
+inline int32_t floatToIntSample(float x, float scale, float lo, float hi, uint32_t* ditherState) {
+  x *= scale;
+  if (ditherState) {
+    x += tpdfDither(*ditherState);
+  }
+  if (x != x) {
+    return 0;
+  }
+  x = std::min(std::max(x, lo), hi);
+  return static_cast<int32_t>(std::lrint(x));
+}
+
+/// Write numOfSamples scaled, optionally dithered and clamped floats to 32 bit integers. With
+/// kToInt16 the values are stored as int16 instead.
+template <typename TReg, bool kToInt16, bool kDither>
+void floatToIntImpl(
+    const float* input,
+    void* output,
+    size_t numOfSamples,
+    float scale,
+    float lo,
+    float hi,
+    uint32_t* ditherState) {
+  const auto regWidth = RegOps<TReg>::width();
+  int16_t* out16 = static_cast<int16_t*>(output);
+  int32_t* out32 = static_cast<int32_t*>(output);
+  float lanes[kMaxRegWidth];
+  TReg in, dither;
+  TReg scaleVec = RegOps<TReg>::set(scale);
+  TReg loVec = RegOps<TReg>::set(lo);
+  TReg hiVec = RegOps<TReg>::set(hi);
+
+  size_t samplesLeft = numOfSamples;
+  while (samplesLeft >= regWidth) {
+    in = RegOps<TReg>::loadU(input);
+    in = RegOps<TReg>::mul(in, scaleVec);
+    if (kDither) {
+      for (size_t k = 0; k < regWidth; ++k) {
+        lanes[k] = tpdfDither(*ditherState);
+      }
+      dither = RegOps<TReg>::loadU(lanes);
+      in = RegOps<TReg>::add(in, dither);
+    }
+    // As floatToIntSample: max() would turn NaN into lo
+    in = RegOps<TReg>::zeroNaN(in);
+    in = RegOps<TReg>::max(in, loVec);
+    in = RegOps<TReg>::min(in, hiVec);
+    if (kToInt16) {
+      RegOps<TReg>::storeI16(out16, in);
+      out16 += regWidth;
+    } else {
+      RegOps<TReg>::storeI32(out32, in);
+      out32 += regWidth;
+    }
+    input += regWidth;
+    samplesLeft -= regWidth;
+  }
+
+  while (samplesLeft--) {
+    const int32_t sample =
+        floatToIntSample(*input++, scale, lo, hi, kDither ? ditherState : nullptr);
+    if (kToInt16) {
+      *out16++ = static_cast<int16_t>(sample);
+    } else {
+      *out32++ = sample;
+    }
+  }
+}
+
+template <typename TReg, bool kToInt16>
+void floatToInt(
+    const float* input,
+    void* output,
+    size_t numOfSamples,
+    float scale,
+    float lo,
+    float hi,
+    uint32_t* ditherState) {
+  if (ditherState) {
+    floatToIntImpl<TReg, kToInt16, true>(input, output, numOfSamples, scale, lo, hi, ditherState);
+  } else {
+    floatToIntImpl<TReg, kToInt16, false>(input, output, numOfSamples, scale, lo, hi, nullptr);
+  }
+}
+
+/// Convert 16 or 32 bit integers to floats scaled by invScale
+template <typename TReg, bool kFromInt16>
+void intToFloat(const void* input, float* output, size_t numOfSamples, float invScale) {
+  const auto regWidth = RegOps<TReg>::width();
+  const int16_t* in16 = static_cast<const int16_t*>(input);
+  const int32_t* in32 = static_cast<const int32_t*>(input);
+  TReg in;
+  TReg scaleVec = RegOps<TReg>::set(invScale);
+
+  size_t samplesLeft = numOfSamples;
+  while (samplesLeft >= regWidth) {
+    if (kFromInt16) {
+      in = RegOps<TReg>::loadI16(in16);
+      in16 += regWidth;
+    } else {
+      in = RegOps<TReg>::loadI32(in32);
+      in32 += regWidth;
+    }
+    in = RegOps<TReg>::mul(in, scaleVec);
+    RegOps<TReg>::storeU(output, in);
+    output += regWidth;
+    samplesLeft -= regWidth;
+  }
+
+  while (samplesLeft--) {
+    *output++ = static_cast<float>(kFromInt16 ? *in16++ : *in32++) * invScale;
+  }
+}
+
+/// Convert signed 16 bit samples to floats in [-1, 1)
+template <typename TReg>
+void convertInt16ToFloat(const int16_t* input, float* output, size_t numOfSamples) {
+  intToFloat<TReg, true>(input, output, numOfSamples, 1.f / kInt16Scale);
+}
+
+template <>
+inline void convertInt16ToFloat<float>(const int16_t* input, float* output, size_t numOfSamples) {
+  while (numOfSamples--) {
+    *output++ = static_cast<float>(*input++) * (1.f / kInt16Scale);
+  }
+}
+
+/// Convert floats to signed 16 bit samples, saturating and with optional TPDF dither
+template <typename TReg>
+void convertFloatToInt16(
+    const float* input,
+    int16_t* output,
+    size_t numOfSamples,
+    uint32_t* ditherState) {
+  floatToInt<TReg, true>(input, output, numOfSamples, kInt16Scale, -32768.f, 32767.f, ditherState);
+}
+
+template <>
+inline void convertFloatToInt16<float>(
+    const float* input,
+    int16_t* output,
+    size_t numOfSamples,
+    uint32_t* ditherState) {
+  while (numOfSamples--) {
+    *output++ = static_cast<int16_t>(
+        floatToIntSample(*input++, kInt16Scale, -32768.f, 32767.f, ditherState));
+  }
+}
+
+/// Convert signed 32 bit samples to floats in [-1, 1)
+template <typename TReg>
+void convertInt32ToFloat(const int32_t* input, float* output, size_t numOfSamples) {
+  intToFloat<TReg, false>(input, output, numOfSamples, 1.f / kInt32Scale);
+}
+
+template <>
+inline void convertInt32ToFloat<float>(const int32_t* input, float* output, size_t numOfSamples) {
+  while (numOfSamples--) {
+    *output++ = static_cast<float>(*input++) * (1.f / kInt32Scale);
+  }
+}
+
+/// Convert floats to signed 32 bit samples, saturating
+template <typename TReg>
+void convertFloatToInt32(const float* input, int32_t* output, size_t numOfSamples) {
+  floatToInt<TReg, false>(
+      input, output, numOfSamples, kInt32Scale, -kInt32Scale, kInt32MaxAsFloat, nullptr);
+}
+
+template <>
+inline void convertFloatToInt32<float>(const float* input, int32_t* output, size_t numOfSamples) {
+  while (numOfSamples--) {
+    *output++ = floatToIntSample(*input++, kInt32Scale, -kInt32Scale, kInt32MaxAsFloat, nullptr);
+  }
+}
+
+/// Convert packed little endian signed 24 bit samples (3 bytes each) to floats in [-1, 1). The
+/// bytes are unpacked to int32 and the conversion to float is vectorised.
+template <typename TReg>
+void convertInt24ToFloat(const uint8_t* input, float* output, size_t numOfSamples) {
+  int32_t tmp[kConvertChunk];
+  while (numOfSamples) {
+    const size_t len = std::min(numOfSamples, kConvertChunk);
+    for (size_t i = 0; i < len; ++i) {
+      const uint32_t packed = static_cast<uint32_t>(input[0]) |
+          (static_cast<uint32_t>(input[1]) << 8) | (static_cast<uint32_t>(input[2]) << 16);
+      tmp[i] = static_cast<int32_t>(packed << 8) >> 8; // sign extend
+      input += 3;
+    }
+    intToFloat<TReg, false>(tmp, output, len, 1.f / kInt24Scale);
+    output += len;
+    numOfSamples -= len;
+  }
+}
+
+template <>
+inline void convertInt24ToFloat<float>(const uint8_t* input, float* output, size_t numOfSamples) {
+  while (numOfSamples--) {
+    const uint32_t packed = static_cast<uint32_t>(input[0]) |
+        (static_cast<uint32_t>(input[1]) << 8) | (static_cast<uint32_t>(input[2]) << 16);
+    *output++ = static_cast<float>(static_cast<int32_t>(packed << 8) >> 8) * (1.f / kInt24Scale);
+    input += 3;
+  }
+}
+
+/// Convert floats to packed little endian signed 24 bit samples (3 bytes each), saturating and
+/// with optional TPDF dither. The scaling, dither and rounding are vectorised, the byte packing
+/// isn't.
+template <typename TReg>
+void convertFloatToInt24(
+    const float* input,
+    uint8_t* output,
+    size_t numOfSamples,
+    uint32_t* ditherState) {
+  int32_t tmp[kConvertChunk];
+  while (numOfSamples) {
+    const size_t len = std::min(numOfSamples, kConvertChunk);
+    floatToInt<TReg, false>(input, tmp, len, kInt24Scale, -8388608.f, 8388607.f, ditherState);
+    for (size_t i = 0; i < len; ++i) {
+      output[0] = static_cast<uint8_t>(tmp[i]);
+      output[1] = static_cast<uint8_t>(tmp[i] >> 8);
+      output[2] = static_cast<uint8_t>(tmp[i] >> 16);
+      output += 3;
+    }
+    input += len;
+    numOfSamples -= len;
+  }
+}
+
+template <>
+inline void convertFloatToInt24<float>(
+    const float* input,
+    uint8_t* output,
+    size_t numOfSamples,
+    uint32_t* ditherState) {
+  while (numOfSamples--) {
+    const int32_t sample =
+        floatToIntSample(*input++, kInt24Scale, -8388608.f, 8388607.f, ditherState);
+    output[0] = static_cast<uint8_t>(sample);
+    output[1] = static_cast<uint8_t>(sample >> 8);
+    output[2] = static_cast<uint8_t>(sample >> 16);
+    output += 3;
+  }
+}
+
+inline void
+interleaveScalar(const float** inputs, size_t numChannels, float* output, size_t numFrames) {
+  for (size_t frame = 0; frame < numFrames; ++frame) {
+    for (size_t ch = 0; ch < numChannels; ++ch) {
+      *output++ = inputs[ch][frame];
+    }
+  }
+}
+
+inline void
+deinterleaveScalar(const float* input, size_t numChannels, float** outputs, size_t numFrames) {
+  for (size_t frame = 0; frame < numFrames; ++frame) {
+    for (size_t ch = 0; ch < numChannels; ++ch) {
+      outputs[ch][frame] = *input++;
+    }
+  }
+}
+
+/// Interleave numChannels planar buffers into a single buffer of frames. Stereo, the common case,
+/// is vectorised with register zips, other channel counts use a plain loop.
+template <typename TReg>
+void interleave(const float** inputs, size_t numChannels, float* output, size_t numFrames) {
+  if (numChannels == 1) {
+    memcpy(output, inputs[0], numFrames * sizeof(float));
+    return;
+  }
+  if (numChannels != 2) {
+    interleaveScalar(inputs, numChannels, output, numFrames);
+    return;
+  }
+
+  const auto regWidth = RegOps<TReg>::width();
+  const float* left = inputs[0];
+  const float* right = inputs[1];
+  TReg a, b, lo, hi;
+  size_t frame = 0;
+  for (; frame + regWidth <= numFrames; frame += regWidth) {
+    a = RegOps<TReg>::loadU(left + frame);
+    b = RegOps<TReg>::loadU(right + frame);
+    RegOps<TReg>::interleave2(a, b, lo, hi);
+    RegOps<TReg>::storeU(output + 2 * frame, lo);
+    RegOps<TReg>::storeU(output + 2 * frame + regWidth, hi);
+  }
+  for (; frame < numFrames; ++frame) {
+    output[2 * frame] = left[frame];
+    output[2 * frame + 1] = right[frame];
+  }
+}
+
+template <>
+inline void
+interleave<float>(const float** inputs, size_t numChannels, float* output, size_t numFrames) {
+  interleaveScalar(inputs, numChannels, output, numFrames);
+}
+
+/// Split a buffer of interleaved frames into numChannels planar buffers. Stereo is vectorised
+/// with register unzips, other channel counts use a plain loop.
+template <typename TReg>
+void deinterleave(const float* input, size_t numChannels, float** outputs, size_t numFrames) {
+  if (numChannels == 1) {
+    memcpy(outputs[0], input, numFrames * sizeof(float));
+    return;
+  }
+  if (numChannels != 2) {
+    deinterleaveScalar(input, numChannels, outputs, numFrames);
+    return;
+  }
+
+  const auto regWidth = RegOps<TReg>::width();
+  float* left = outputs[0];
+  float* right = outputs[1];
+  TReg a, b, lo, hi;
+  size_t frame = 0;
+  for (; frame + regWidth <= numFrames; frame += regWidth) {
+    lo = RegOps<TReg>::loadU(input + 2 * frame);
+    hi = RegOps<TReg>::loadU(input + 2 * frame + regWidth);
+    RegOps<TReg>::deinterleave2(lo, hi, a, b);
+    RegOps<TReg>::storeU(left + frame, a);
+    RegOps<TReg>::storeU(right + frame, b);
+  }
+  for (; frame < numFrames; ++frame) {
+    left[frame] = input[2 * frame];
+    right[frame] = input[2 * frame + 1];
+  }
+}
+
+template <>
+inline void
+deinterleave<float>(const float* input, size_t numChannels, float** outputs, size_t numFrames) {
+  deinterleaveScalar(input, numChannels, outputs, numFrames);
+}
+
+/// Scale a buffer, add a second one, apply an output gain and clip, in one pass
+/// (output[i] = clip((a[i] * scalar + b[i]) * outputGain, -clipLevel, clipLevel))
+template <typename TReg>
+void mixAndClip(
+    const float* inputToScale,
+    float scalar,
+    const float* bufferToAdd,
+    float outputGain,
+    float clipLevel,
+    float* output,
+    size_t numOfSamples) {
+  using namespace Expr;
+  evaluate<TReg>(
+      clip((Input(inputToScale) * scalar + Input(bufferToAdd)) * outputGain, -clipLevel, clipLevel),
+      output,
+      numOfSamples);
+}
+
+} // namespace Internal
+} // namespace TBE
+
+//
+// The kernels above only depend on RegOps, so that StaticDSP.hh can bind them from within DSP.hh.
+// FBDSP is only needed from here on.
+//
+#include "DSP.hh"
+
+namespace TBE {
+namespace Internal {
+#ifndef TBE_STATIC_ISA
+/// Fill a runtime dispatched FBDSP with the kernels of one RegOps type
 template <typename T>
 void dspInit(FBDSP* d) {
   assert(d);
@@ -230,7 +1423,30 @@ void dspInit(FBDSP* d) {
   d->addScalar = addScalar<T>;
   d->multiplyInputAndAdd = multiplyInputAndAdd<T>;
   d->isBufferSilent = isBufferSilent<T>;
+  d->peak = peak<T>;
+  d->sum = sum<T>;
+  d->sumOfSquares = sumOfSquares<T>;
+  d->dotProduct = dotProduct<T>;
+  d->minMax = minMax<T>;
+  d->convertInt16ToFloat = convertInt16ToFloat<T>;
+  d->convertFloatToInt16 = convertFloatToInt16<T>;
+  d->convertInt24ToFloat = convertInt24ToFloat<T>;
+  d->convertFloatToInt24 = convertFloatToInt24<T>;
+  d->convertInt32ToFloat = convertInt32ToFloat<T>;
+  d->convertFloatToInt32 = convertFloatToInt32<T>;
+  d->interleave = interleave<T>;
+  d->mixAndClip = mixAndClip<T>;
+  d->deinterleave = deinterleave<T>;
+  d->multiplyRamp = multiplyRamp<T>;
+  d->multiplyRampExp = multiplyRampExp<T>;
+  d->multiplyRampAndAdd = multiplyRampAndAdd<T>;
+  d->multiplyRampExpAndAdd = multiplyRampExpAndAdd<T>;
+  d->matrixMix = matrixMix<T>;
+  d->matrixMixAdd = matrixMixAdd<T>;
+  d->matrixMixBlockDiagonal = matrixMixBlockDiagonal<T>;
+  d->matrixMixInterpolated = matrixMixInterpolated<T>;
 }
+#endif // TBE_STATIC_ISA
 
 } // namespace Internal
 } // namespace TBE
@@ -0,0 +1,66 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+namespace TBE {
+/// The bytes held by an object, e.g. to plan how many renderers fit on a host:
+///
+///   const MemoryFootprint footprint = renderer.memoryFootprint();
+///   const size_t perRenderer = footprint.getPrivate();
+///
+/// Split by what the bytes are used for:
+///  - coefficients: filter taps, read only while processing
+///  - state: carried from one call to the next, e.g. delay lines, and the objects themselves
+///  - scratch: only live during a call, contents are not kept
+///
+/// Each is split again into private bytes, used by this object alone, and shared bytes, which
+/// the object reads but other objects or the caller may use too, e.g. buffers it doesn't own.
+/// Shared bytes are reported by every object that uses them, so add them up once per owner.
+/// Allocator overhead is not counted.
+struct MemoryFootprint {
+  struct Bytes {
+    size_t privateBytes{0};
+    size_t sharedBytes{0};
+
+    size_t getTotal() const {
+      return privateBytes + sharedBytes;
+    }
+
+    Bytes& operator+=(const Bytes& other) {
+      privateBytes += other.privateBytes;
+      sharedBytes += other.sharedBytes;
+      return *this;
+    }
+  };
+
+  Bytes coefficients;
+  Bytes state;
+  Bytes scratch;
+
+  size_t getPrivate() const {
+    return coefficients.privateBytes + state.privateBytes + scratch.privateBytes;
+  }
+
+  size_t getShared() const {
+    return coefficients.sharedBytes + state.sharedBytes + scratch.sharedBytes;
+  }
+
+  size_t getTotal() const {
+    return getPrivate() + getShared();
+  }
+
+  MemoryFootprint& operator+=(const MemoryFootprint& other) {
+    coefficients += other.coefficients;
+    state += other.state;
+    scratch += other.scratch;
+    return *this;
+  }
+};
+} // namespace TBE
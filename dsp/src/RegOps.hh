@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TBE {
+template <typename T>
+struct RegOps {
+  static size_t width();
+  static T zero();
+  static T mul(T& a, T& b);
+  static T mul(T& a, float& scalar);
+  static T add(T& a, T& b);
+  static T sub(T& a, T& b);
+  static T set(const float& val);
+  static T mulAcc(T& acc, T& a, T& b);
+  static T min(T& a, T& b);
+  static T max(T& a, T& b);
+  // As max, but NaN if either lane is NaN
+  static T maxNaN(T& a, T& b);
+  // Zero in the lanes that are NaN
+  static T zeroNaN(T& a);
+  static T abs(T& a);
+  static T loadU(const float* buffer);
+  static void storeU(float* buffer, T& a);
+  // Aligned to width() floats
+  static T load(const float* buffer);
+  static void store(float* buffer, T& a);
+  // Integer conversions. Stores round to nearest and storeI16 saturates.
+  static T loadI16(const int16_t* buffer);
+  static void storeI16(int16_t* buffer, T& a);
+  static T loadI32(const int32_t* buffer);
+  static void storeI32(int32_t* buffer, T& a);
+  // Stereo (de)interleave: a = left, b = right <-> lo, hi = the interleaved frames in order
+  static void interleave2(T& a, T& b, T& lo, T& hi);
+  static void deinterleave2(T& lo, T& hi, T& a, T& b);
+};
+
+// A register of one float, for the scalar tier of the FIR so that it shares the delay line
+// layout of the SIMD tiers. Only the operations FIR::process needs.
+template <>
+struct RegOps<float> {
+  static size_t width() {
+    return 1;
+  }
+
+  static float zero() {
+    return 0.f;
+  }
+
+  static float set(const float& val) {
+    return val;
+  }
+
+  static float mulAcc(float& acc, float& a, float& b) {
+    return acc + a * b;
+  }
+
+  static float loadU(const float* buffer) {
+    return *buffer;
+  }
+
+  static void storeU(float* buffer, float& a) {
+    *buffer = a;
+  }
+};
+} // namespace TBE
@@ -0,0 +1,133 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#if defined(__AVX__)
+
+#include "RegOps.hh"
+#include "immintrin.h"
+#include "xmmintrin.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace TBE {
+template <>
+struct RegOps<__m256> {
+  static size_t width() {
+    return 8;
+  }
+
+  static __m256 zero() {
+    return _mm256_setzero_ps();
+  }
+
+  static __m256 mul(__m256& a, __m256& b) {
+    return _mm256_mul_ps(a, b);
+  }
+
+  static __m256 mul(__m256& v, float& scalar) {
+    auto s = set(scalar);
+    return mul(v, s);
+  }
+
+  static __m256 add(__m256& a, __m256& b) {
+    return _mm256_add_ps(a, b);
+  }
+
+  static __m256 set(const float& val) {
+    return _mm256_set1_ps(val);
+  }
+
+  static __m256 sub(__m256& a, __m256& b) {
+    return _mm256_sub_ps(a, b);
+  }
+
+  static __m256 mulAcc(__m256& acc, __m256& a, __m256& b) {
+    return _mm256_add_ps(acc, _mm256_mul_ps(a, b));
+  }
+
+  static __m256 min(__m256& a, __m256& b) {
+    return _mm256_min_ps(a, b);
+  }
+
+  static __m256 max(__m256& a, __m256& b) {
+    return _mm256_max_ps(a, b);
+  }
+
+  static __m256 maxNaN(__m256& a, __m256& b) {
+    // vmaxps returns b if either is NaN, a NaN a is or-ed back in
+    const __m256 aIsNaN = _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+    return _mm256_or_ps(_mm256_max_ps(a, b), _mm256_and_ps(aIsNaN, a));
+  }
+
+  static __m256 zeroNaN(__m256& a) {
+    return _mm256_and_ps(a, _mm256_cmp_ps(a, a, _CMP_ORD_Q));
+  }
+
+  static __m256 abs(__m256& a) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a);
+  }
+
+  static __m256 loadU(const float* buffer) {
+    return _mm256_loadu_ps(buffer);
+  }
+
+  static void storeU(float* buffer, __m256& a) {
+    _mm256_storeu_ps(buffer, a);
+  }
+
+  static __m256 load(const float* buffer) {
+    return _mm256_load_ps(buffer);
+  }
+
+  static void store(float* buffer, __m256& a) {
+    _mm256_store_ps(buffer, a);
+  }
+
+  // AVX has no 256 bit integer ops, so the integer work is done on 128 bit halves
+  static __m256 loadI16(const int16_t* buffer) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+    return _mm256_cvtepi32_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+  }
+
+  static void storeI16(int16_t* buffer, __m256& a) {
+    __m256i out32 = _mm256_cvtps_epi32(a);
+    __m128i lo = _mm256_castsi256_si128(out32);
+    __m128i hi = _mm256_extractf128_si256(out32, 1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), _mm_packs_epi32(lo, hi));
+  }
+
+  static __m256 loadI32(const int32_t* buffer) {
+    return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer)));
+  }
+
+  static void storeI32(int32_t* buffer, __m256& a) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer), _mm256_cvtps_epi32(a));
+  }
+
+  static void interleave2(__m256& a, __m256& b, __m256& lo, __m256& hi) {
+    // unpack works within 128 bit lanes, the permutes put the frames back in order
+    __m256 l = _mm256_unpacklo_ps(a, b);
+    __m256 h = _mm256_unpackhi_ps(a, b);
+    lo = _mm256_permute2f128_ps(l, h, 0x20);
+    hi = _mm256_permute2f128_ps(l, h, 0x31);
+  }
+
+  static void deinterleave2(__m256& lo, __m256& hi, __m256& a, __m256& b) {
+    __m256 l = _mm256_permute2f128_ps(lo, hi, 0x20);
+    __m256 h = _mm256_permute2f128_ps(lo, hi, 0x31);
+    a = _mm256_shuffle_ps(l, h, _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm256_shuffle_ps(l, h, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+};
+} // namespace TBE
+
+#endif // __AVX__
@@ -0,0 +1,130 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#ifdef __ARM_NEON
+
+#include <arm_neon.h>
+#include "RegOps.hh"
+
+namespace TBE {
+template <>
+struct RegOps<float32x4_t> {
+  static size_t width() {
+    return 4;
+  }
+
+  static float32x4_t zero() {
+    return vdupq_n_f32(0);
+  }
+
+  static float32x4_t mul(float32x4_t& a, float32x4_t& b) {
+    return vmulq_f32(a, b);
+  }
+
+  static float32x4_t mul(float32x4_t& v, float& scalar) {
+    return vmulq_n_f32(v, scalar);
+  }
+
+  static float32x4_t add(float32x4_t& a, float32x4_t& b) {
+    return vaddq_f32(a, b);
+  }
+
+  static float32x4_t set(const float& val) {
+    return vdupq_n_f32(val);
+  }
+
+  static float32x4_t sub(float32x4_t& a, float32x4_t& b) {
+    return vsubq_f32(a, b);
+  }
+
+  static float32x4_t mulAcc(float32x4_t& acc, float32x4_t& a, float32x4_t& b) {
+    return vmlaq_f32(acc, a, b);
+  }
+
+  static float32x4_t min(float32x4_t& a, float32x4_t& b) {
+    return vminq_f32(a, b);
+  }
+
+  static float32x4_t max(float32x4_t& a, float32x4_t& b) {
+    return vmaxq_f32(a, b);
+  }
+
+  static float32x4_t maxNaN(float32x4_t& a, float32x4_t& b) {
+    // vmax already returns NaN if either is NaN
+    return vmaxq_f32(a, b);
+  }
+
+  static float32x4_t zeroNaN(float32x4_t& a) {
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vceqq_f32(a, a)));
+  }
+
+  static float32x4_t abs(float32x4_t& a) {
+    return vabsq_f32(a);
+  }
+
+  static float32x4_t loadU(const float* buffer) {
+    return vld1q_f32(buffer);
+  }
+
+  static void storeU(float* buffer, float32x4_t& a) {
+    vst1q_f32(buffer, a);
+  }
+
+  // vld1q/vst1q handle both, the alignment only saves the hardware a split access
+  static float32x4_t load(const float* buffer) {
+    return vld1q_f32(buffer);
+  }
+
+  static void store(float* buffer, float32x4_t& a) {
+    vst1q_f32(buffer, a);
+  }
+
+  static float32x4_t loadI16(const int16_t* buffer) {
+    return vcvtq_f32_s32(vmovl_s16(vld1_s16(buffer)));
+  }
+
+  static int32x4_t roundToInt(float32x4_t& a) {
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(a);
+#else
+    // vcvtq truncates, so add half with the sign of the value first
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(0x80000000));
+    const float32x4_t half =
+        vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+    return vcvtq_s32_f32(vaddq_f32(a, half));
+#endif
+  }
+
+  static void storeI16(int16_t* buffer, float32x4_t& a) {
+    vst1_s16(buffer, vqmovn_s32(roundToInt(a)));
+  }
+
+  static float32x4_t loadI32(const int32_t* buffer) {
+    return vcvtq_f32_s32(vld1q_s32(buffer));
+  }
+
+  static void storeI32(int32_t* buffer, float32x4_t& a) {
+    vst1q_s32(buffer, roundToInt(a));
+  }
+
+  static void interleave2(float32x4_t& a, float32x4_t& b, float32x4_t& lo, float32x4_t& hi) {
+    float32x4x2_t zipped = vzipq_f32(a, b);
+    lo = zipped.val[0];
+    hi = zipped.val[1];
+  }
+
+  static void deinterleave2(float32x4_t& lo, float32x4_t& hi, float32x4_t& a, float32x4_t& b) {
+    float32x4x2_t unzipped = vuzpq_f32(lo, hi);
+    a = unzipped.val[0];
+    b = unzipped.val[1];
+  }
+};
+} // namespace TBE
+
+#endif // __ARM_NEON
@@ -0,0 +1,125 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#ifndef __ARM_NEON
+
+#include "RegOps.hh"
+#include "immintrin.h"
+#include "xmmintrin.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace TBE {
+template <>
+struct RegOps<__m128> {
+  static size_t width() {
+    return 4;
+  }
+
+  static __m128 zero() {
+    return _mm_setzero_ps();
+  }
+
+  static __m128 mul(__m128& a, __m128& b) {
+    return _mm_mul_ps(a, b);
+  }
+
+  static __m128 mul(__m128& v, float& scalar) {
+    auto s = set(scalar);
+    return mul(v, s);
+  }
+
+  static __m128 add(__m128& a, __m128& b) {
+    return _mm_add_ps(a, b);
+  }
+
+  static __m128 set(const float& val) {
+    return _mm_set1_ps(val);
+  }
+
+  static __m128 sub(__m128& a, __m128& b) {
+    return _mm_sub_ps(a, b);
+  }
+
+  static __m128 mulAcc(__m128& acc, __m128& a, __m128& b) {
+    return _mm_add_ps(acc, _mm_mul_ps(a, b));
+  }
+
+  static __m128 min(__m128& a, __m128& b) {
+    return _mm_min_ps(a, b);
+  }
+
+  static __m128 max(__m128& a, __m128& b) {
+    return _mm_max_ps(a, b);
+  }
+
+  static __m128 maxNaN(__m128& a, __m128& b) {
+    // maxps returns b if either is NaN, a NaN a is or-ed back in
+    const __m128 aIsNaN = _mm_cmpunord_ps(a, a);
+    return _mm_or_ps(_mm_max_ps(a, b), _mm_and_ps(aIsNaN, a));
+  }
+
+  static __m128 zeroNaN(__m128& a) {
+    return _mm_and_ps(a, _mm_cmpord_ps(a, a));
+  }
+
+  static __m128 abs(__m128& a) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), a);
+  }
+
+  static __m128 loadU(const float* buffer) {
+    return _mm_loadu_ps(buffer);
+  }
+
+  static void storeU(float* buffer, __m128& a) {
+    _mm_storeu_ps(buffer, a);
+  }
+
+  static __m128 load(const float* buffer) {
+    return _mm_load_ps(buffer);
+  }
+
+  static void store(float* buffer, __m128& a) {
+    _mm_store_ps(buffer, a);
+  }
+
+  static __m128 loadI16(const int16_t* buffer) {
+    __m128i in = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(buffer));
+    // Sign extend by moving each value to the top half of a 32 bit lane
+    __m128i in32 = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+    return _mm_cvtepi32_ps(in32);
+  }
+
+  static void storeI16(int16_t* buffer, __m128& a) {
+    __m128i out32 = _mm_cvtps_epi32(a);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(buffer), _mm_packs_epi32(out32, out32));
+  }
+
+  static __m128 loadI32(const int32_t* buffer) {
+    return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer)));
+  }
+
+  static void storeI32(int32_t* buffer, __m128& a) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), _mm_cvtps_epi32(a));
+  }
+
+  static void interleave2(__m128& a, __m128& b, __m128& lo, __m128& hi) {
+    lo = _mm_unpacklo_ps(a, b);
+    hi = _mm_unpackhi_ps(a, b);
+  }
+
+  static void deinterleave2(__m128& lo, __m128& hi, __m128& a, __m128& b) {
+    a = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+};
+} // namespace TBE
+
+#endif // __ARM_NEON
@@ -0,0 +1,77 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+namespace TBE {
+/// Publishes copies of a plain struct from one thread, typically the audio thread, to any number
+/// of readers without locks. publish() never waits; read() retries while a publish is in
+/// progress, so readers such as a telemetry poller can't hold up the writer.
+///
+/// T must be trivially copyable. The copy is kept in relaxed atomic words guarded by a sequence
+/// number (a seqlock), so a reader never sees a half written struct.
+template <typename T>
+class SeqLockSnapshot {
+  static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+ public:
+  SeqLockSnapshot() {
+    for (size_t i = 0; i < kNumWords; ++i) {
+      words_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  SeqLockSnapshot(const SeqLockSnapshot&) = delete;
+  SeqLockSnapshot& operator=(const SeqLockSnapshot&) = delete;
+
+  /// Single writer only. Wait-free
+  void publish(const T& value) {
+    uint64_t words[kNumWords] = {};
+    memcpy(words, &value, sizeof(T));
+
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    // Odd while the words are being written
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kNumWords; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /// Any thread. Lock-free
+  /// \return The last published value, or a zeroed T if nothing was published yet
+  T read() const {
+    uint64_t words[kNumWords];
+    uint32_t before, after;
+    do {
+      before = sequence_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < kNumWords; ++i) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+ private:
+  static const size_t kNumWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<uint64_t> words_[kNumWords];
+};
+} // namespace TBE
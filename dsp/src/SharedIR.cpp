@@ -0,0 +1,113 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "SharedIR.hh"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include "AlignedMemory.hh"
+
+namespace TBE {
+namespace {
+// The stored IRs by a hash of their content. Entries only hold a weak reference, so an IR is
+// released with its last filter and its entry is dropped by the next get()
+struct Store {
+  std::mutex mutex;
+  std::unordered_multimap<uint64_t, std::weak_ptr<const SharedIR>> irs;
+};
+
+Store& store() {
+  // Thread safe static initialisation
+  static Store instance;
+  return instance;
+}
+
+// FNV-1a over the samples and the tap count
+uint64_t hashIR(const float* ir, size_t irLength, size_t numTaps) {
+  uint64_t hash = 14695981039346656037ull;
+  const auto mix = [&hash](const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+  };
+  mix(ir, irLength * sizeof(float));
+  mix(&numTaps, sizeof(numTaps));
+  return hash;
+}
+} // namespace
+
+SharedIR::SharedIR(const float* ir, size_t irLength, size_t numTaps) : numTaps_(numTaps) {
+  assert(irLength <= numTaps);
+  taps_ = static_cast<float*>(alignedMalloc(getSize()));
+  assert(taps_);
+  // Reversed like FIR::setIR: the padding of a shorter IR ends up in front
+  memset(taps_, 0, getSize());
+  for (size_t i = 1; i <= irLength; ++i) {
+    taps_[numTaps - i] = ir[i - 1];
+  }
+}
+
+SharedIR::~SharedIR() {
+  alignedFree(taps_);
+}
+
+size_t SharedIR::getSize() const {
+  return alignUp(numTaps_ * sizeof(float), kCacheLineSize);
+}
+
+bool SharedIR::matches(const float* ir, size_t irLength, size_t numTaps) const {
+  if (numTaps != numTaps_) {
+    return false;
+  }
+  for (size_t i = 1; i <= numTaps; ++i) {
+    const float expected = i <= irLength ? ir[i - 1] : 0.f;
+    // Bitwise, so that -0 and NaN payloads are kept
+    if (memcmp(&taps_[numTaps - i], &expected, sizeof(float)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SharedIR::Ptr SharedIR::get(const float* ir, size_t irLength, size_t numTaps) {
+  assert(ir || irLength == 0);
+  const uint64_t hash = hashIR(ir, irLength, numTaps);
+  Store& irs = store();
+  std::lock_guard<std::mutex> lock(irs.mutex);
+
+  const auto range = irs.irs.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    Ptr stored = it->second.lock();
+    if (stored && stored->matches(ir, irLength, numTaps)) {
+      return stored;
+    }
+  }
+
+  // Drop the entries of released IRs before adding this one
+  for (auto it = irs.irs.begin(); it != irs.irs.end();) {
+    it = it->second.expired() ? irs.irs.erase(it) : std::next(it);
+  }
+  Ptr created(new SharedIR(ir, irLength, numTaps));
+  irs.irs.emplace(hash, created);
+  return created;
+}
+
+size_t SharedIR::numStored() {
+  Store& irs = store();
+  std::lock_guard<std::mutex> lock(irs.mutex);
+  size_t count = 0;
+  for (const auto& entry : irs.irs) {
+    count += entry.second.expired() ? 0 : 1;
+  }
+  return count;
+}
+} // namespace TBE
@@ -0,0 +1,64 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+
+namespace TBE {
+/// The taps of an impulse response, reversed and aligned the way FIR processes them, shared
+/// read-only by every filter built from the same IR instead of each one keeping a private copy.
+/// Typical use, e.g. for many renderers on the same set of IRs:
+///
+///   SharedIR::Ptr taps = SharedIR::get(ir, irLength, numTaps);
+///   FIR fir(taps);
+///
+/// get() returns the stored taps if an IR with the same content and tap count is alive, so
+/// equal IRs are shared even when they come from different arrays. The taps are released with
+/// the last filter holding them. get() locks a mutex and may allocate: construction time only,
+/// never on the audio thread. The taps themselves are immutable and may be read from any thread.
+class SharedIR {
+ public:
+  using Ptr = std::shared_ptr<const SharedIR>;
+
+  /// \param ir The impulse response, in its natural order
+  /// \param irLength Number of samples in ir, at most numTaps
+  /// \param numTaps Number of taps of the filter, ir is zero-padded at the end to this length
+  /// \return The shared taps of this IR
+  static Ptr get(const float* ir, size_t irLength, size_t numTaps);
+
+  /// \return The number of IRs stored and still in use, e.g. to check that they are shared
+  static size_t numStored();
+
+  ~SharedIR();
+
+  SharedIR(const SharedIR&) = delete;
+  SharedIR& operator=(const SharedIR&) = delete;
+
+  /// \return The reversed taps, aligned to kCacheLineSize
+  const float* getTaps() const {
+    return taps_;
+  }
+
+  size_t getNumTaps() const {
+    return numTaps_;
+  }
+
+  /// \return The bytes taken by the taps
+  size_t getSize() const;
+
+ private:
+  SharedIR(const float* ir, size_t irLength, size_t numTaps);
+
+  // True if this holds the taps get() would build from ir
+  bool matches(const float* ir, size_t irLength, size_t numTaps) const;
+
+  float* taps_{nullptr};
+  size_t numTaps_{0};
+};
+} // namespace TBE
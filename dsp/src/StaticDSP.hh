@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "DSP.hh"
+#include "Internal.hh"
+
+#ifndef TBE_STATIC_ISA
+#error StaticDSP.hh is only used in the static single-ISA mode, include DSP.hh instead
+#endif
+
+namespace TBE {
+//
+// Forwards FBDSP::name(...) to Internal::name<TBE_STATIC_REG>(...). Being a template in a header
+// the kernel can be inlined, and fused with its neighbours, at every call site.
+//
+#define TBE_STATIC_KERNEL(name)                                                  \
+  template <typename... TArgs>                                                   \
+  static auto name(TArgs... args)->decltype(Internal::name<Reg>(args...)) {      \
+    return Internal::name<Reg>(args...);                                          \
+  }
+
+/// FBDSP of the static single-ISA mode. Has the same functions as the runtime dispatched FBDSP
+/// (see DSP.hh for their documentation) but they are bound at build time to TBE_STATIC_REG, so
+/// the class holds no state. Typical use is unchanged: FBDSP dsp; dsp.multiply(inoutA, inputB,
+/// output, numOfSamples);
+class FBDSP {
+ public:
+  using Reg = TBE_STATIC_REG;
+
+  /// \return A process-wide instance, to match the runtime dispatched FBDSP
+  static const FBDSP& shared() {
+    static const FBDSP dsp{};
+    return dsp;
+  }
+
+  TBE_STATIC_KERNEL(multiply)
+  TBE_STATIC_KERNEL(multiplyScalar)
+  TBE_STATIC_KERNEL(add)
+  TBE_STATIC_KERNEL(addScalar)
+  TBE_STATIC_KERNEL(multiplyInputAndAdd)
+  TBE_STATIC_KERNEL(isBufferSilent)
+  TBE_STATIC_KERNEL(mixAndClip)
+  TBE_STATIC_KERNEL(peak)
+  TBE_STATIC_KERNEL(sum)
+  TBE_STATIC_KERNEL(sumOfSquares)
+  TBE_STATIC_KERNEL(dotProduct)
+  TBE_STATIC_KERNEL(minMax)
+  TBE_STATIC_KERNEL(convertInt16ToFloat)
+  TBE_STATIC_KERNEL(convertFloatToInt16)
+  TBE_STATIC_KERNEL(convertInt24ToFloat)
+  TBE_STATIC_KERNEL(convertFloatToInt24)
+  TBE_STATIC_KERNEL(convertInt32ToFloat)
+  TBE_STATIC_KERNEL(convertFloatToInt32)
+  TBE_STATIC_KERNEL(interleave)
+  TBE_STATIC_KERNEL(deinterleave)
+  TBE_STATIC_KERNEL(multiplyRamp)
+  TBE_STATIC_KERNEL(multiplyRampExp)
+  TBE_STATIC_KERNEL(multiplyRampAndAdd)
+  TBE_STATIC_KERNEL(multiplyRampExpAndAdd)
+  TBE_STATIC_KERNEL(matrixMix)
+  TBE_STATIC_KERNEL(matrixMixAdd)
+  TBE_STATIC_KERNEL(matrixMixBlockDiagonal)
+  TBE_STATIC_KERNEL(matrixMixInterpolated)
+};
+
+#undef TBE_STATIC_KERNEL
+} // namespace TBE
@@ -0,0 +1,129 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace TBE {
+namespace Bench {
+/// Reported instead of an infinite SNR when a signal matches its reference exactly
+static const double kMaxSnrDb = 300.0;
+
+/// \return The convolution of input with ir, y[n] = sum h[k] x[n - k], computed in double
+/// precision from a zero initial state. numSamples long, like the output of FIR::process
+template <typename T>
+std::vector<double>
+directConvolution(const T* input, size_t numSamples, const float* ir, size_t numTaps) {
+  std::vector<double> output(numSamples, 0.0);
+  for (size_t n = 0; n < numSamples; ++n) {
+    double y = 0.0;
+    const size_t count = std::min(numTaps, n + 1);
+    for (size_t k = 0; k < count; ++k) {
+      y += static_cast<double>(ir[k]) * static_cast<double>(input[n - k]);
+    }
+    output[n] = y;
+  }
+  return output;
+}
+
+/// How far a rendered signal is from its reference
+struct SignalError {
+  /// Reference energy over error energy, kMaxSnrDb if there is no error
+  double snrDb;
+  /// Largest absolute difference of a sample
+  double maxError;
+};
+
+/// Sums up the error of test signals against their references, e.g. over both ears
+class ErrorAccumulator {
+ public:
+  template <typename T>
+  void add(const double* reference, const T* test, size_t numSamples) {
+    for (size_t i = 0; i < numSamples; ++i) {
+      const double diff = static_cast<double>(test[i]) - reference[i];
+      signalEnergy_ += reference[i] * reference[i];
+      errorEnergy_ += diff * diff;
+      maxError_ = std::max(maxError_, std::abs(diff));
+    }
+  }
+
+  SignalError get() const {
+    SignalError error;
+    error.maxError = maxError_;
+    if (errorEnergy_ == 0.0) {
+      error.snrDb = kMaxSnrDb;
+    } else {
+      error.snrDb = std::min(kMaxSnrDb, 10.0 * std::log10(signalEnergy_ / errorEnergy_));
+    }
+    return error;
+  }
+
+ private:
+  double signalEnergy_{0.0};
+  double errorEnergy_{0.0};
+  double maxError_{0.0};
+};
+
+/// \return The error of test against reference
+template <typename T>
+SignalError compareSignals(const double* reference, const T* test, size_t numSamples) {
+  ErrorAccumulator accumulator;
+  accumulator.add(reference, test, numSamples);
+  return accumulator.get();
+}
+
+/// \return The interaural level difference in dB, positive when the left ear is louder
+template <typename T>
+double interauralLevelDifferenceDb(const T* left, const T* right, size_t numSamples) {
+  double leftEnergy = 0.0;
+  double rightEnergy = 0.0;
+  for (size_t i = 0; i < numSamples; ++i) {
+    leftEnergy += static_cast<double>(left[i]) * left[i];
+    rightEnergy += static_cast<double>(right[i]) * right[i];
+  }
+  if (leftEnergy == 0.0 || rightEnergy == 0.0) {
+    return 0.0;
+  }
+  return 10.0 * std::log10(leftEnergy / rightEnergy);
+}
+
+/// \return The interaural time difference in samples: the lag within +-maxLag at which the
+/// cross-correlation of the ears peaks, refined to a fraction of a sample by fitting a parabola
+/// through the peak. Positive when the right ear lags, i.e. for a source on the left.
+template <typename T>
+double interauralTimeDifference(const T* left, const T* right, size_t numSamples, int maxLag) {
+  std::vector<double> correlation(2 * maxLag + 1, 0.0);
+  for (int lag = -maxLag; lag <= maxLag; ++lag) {
+    const size_t begin = lag < 0 ? -lag : 0;
+    const size_t end = lag > 0 ? numSamples - lag : numSamples;
+    double sum = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+      sum += static_cast<double>(left[i]) * right[i + lag];
+    }
+    correlation[lag + maxLag] = sum;
+  }
+
+  const int peak = static_cast<int>(
+      std::max_element(correlation.begin(), correlation.end()) - correlation.begin());
+  double offset = 0.0;
+  if (peak > 0 && peak < 2 * maxLag) {
+    const double before = correlation[peak - 1];
+    const double at = correlation[peak];
+    const double after = correlation[peak + 1];
+    const double curvature = before - 2.0 * at + after;
+    if (curvature < 0.0) {
+      offset = 0.5 * (before - after) / curvature;
+    }
+  }
+  return peak - maxLag + offset;
+}
+} // namespace Bench
+} // namespace TBE
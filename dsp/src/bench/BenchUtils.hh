@@ -0,0 +1,269 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "PerfCounters.hh"
+
+namespace TBE {
+namespace Bench {
+/// Command line options shared by the benchmark apps
+struct Options {
+  /// Write the results as one JSON document instead of a text table
+  bool json{false};
+  /// Smaller sweeps and shorter runs, for a smoke test
+  bool quick{false};
+  /// Each case is repeated until it ran for at least this long
+  double minTimeMs{20.0};
+  /// Only run the cases whose name contains this string
+  std::string filter;
+  /// Read the hardware performance counters while measuring, where available
+  bool counters{true};
+};
+
+/// Parse --json, --quick, --min-time-ms=N, --filter=S and --no-counters
+/// \return False, after printing the usage, on an unknown argument or --help
+inline bool parseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "--json") == 0) {
+      options->json = true;
+    } else if (strcmp(arg, "--quick") == 0) {
+      options->quick = true;
+      options->minTimeMs = 2.0;
+    } else if (strncmp(arg, "--min-time-ms=", 14) == 0) {
+      options->minTimeMs = atof(arg + 14);
+    } else if (strncmp(arg, "--filter=", 9) == 0) {
+      options->filter = arg + 9;
+    } else if (strcmp(arg, "--no-counters") == 0) {
+      options->counters = false;
+    } else {
+      fprintf(
+          stderr,
+          "Usage: %s [--json] [--quick] [--min-time-ms=N] [--filter=SUBSTRING] [--no-counters]\n",
+          argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \return True if the case should run with these options
+inline bool selected(const Options& options, const std::string& name) {
+  return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+/// \return Average nanoseconds per call of fn, which is called at least 3 times to warm up and
+/// then in doubling batches until minTimeMs have passed
+/// \param counters If not null, counts the timed calls
+template <typename TFn>
+double measure(
+    TFn&& fn,
+    double minTimeMs,
+    size_t* numCalls = nullptr,
+    PerfCounters* counters = nullptr) {
+  using Clock = std::chrono::steady_clock;
+  for (int i = 0; i < 3; ++i) {
+    fn();
+  }
+
+  if (counters) {
+    counters->start();
+  }
+  size_t total = 0;
+  size_t batch = 1;
+  double elapsedNs = 0.0;
+  while (elapsedNs < minTimeMs * 1e6) {
+    const auto start = Clock::now();
+    for (size_t i = 0; i < batch; ++i) {
+      fn();
+    }
+    elapsedNs += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    total += batch;
+    batch *= 2;
+  }
+  if (counters) {
+    counters->stop();
+  }
+  if (numCalls) {
+    *numCalls = total;
+  }
+  return elapsedNs / total;
+}
+
+/// One row of results: a name and named text or number fields, in insertion order
+class Result {
+ public:
+  explicit Result(std::string name) : name_(std::move(name)) {}
+
+  Result& set(const char* key, double value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.6g", value);
+    fields_.emplace_back(key, Field{text, true});
+    return *this;
+  }
+
+  Result& set(const char* key, const std::string& value) {
+    fields_.emplace_back(key, Field{value, false});
+    return *this;
+  }
+
+  Result& set(const char* key, const char* value) {
+    return set(key, std::string(value));
+  }
+
+  /// Add the counts per run, and the instructions per cycle, of the events that could be read.
+  /// Does nothing without counters.
+  /// \param numRuns The number of runs the counters were read over
+  Result& setCounters(const PerfCounters* counters, double numRuns) {
+    if (!counters) {
+      return *this;
+    }
+    for (int i = 0; i < PerfCounters::NUM_EVENTS; ++i) {
+      const auto event = static_cast<PerfCounters::Event>(i);
+      if (!std::isnan(counters->getValue(event))) {
+        set(PerfCounters::eventName(event), counters->getValue(event) / numRuns);
+      }
+    }
+    const double cycles = counters->getValue(PerfCounters::CYCLES);
+    const double instructions = counters->getValue(PerfCounters::INSTRUCTIONS);
+    if (cycles > 0.0 && !std::isnan(instructions)) {
+      set("ipc", instructions / cycles);
+    }
+    return *this;
+  }
+
+ private:
+  friend class Report;
+
+  struct Field {
+    std::string text;
+    bool isNumber;
+  };
+
+  std::string name_;
+  std::vector<std::pair<std::string, Field>> fields_;
+};
+
+/// Prints results as they come in as a text table, or collects them and prints a single JSON
+/// document of the form {"benchmark": ..., "context": {...}, "results": [{"name": ..., ...}]} when
+/// finish() is called
+class Report {
+ public:
+  Report(const char* benchmark, const Options& options)
+      : benchmark_(benchmark), context_(""), json_(options.json) {
+    if (options.counters) {
+      counters_.reset(new PerfCounters());
+      context_.set("perf_counters", counters_->describe());
+    } else {
+      context_.set("perf_counters", "disabled");
+    }
+  }
+
+  /// Describes the run, e.g. the CPU tier. Printed once, before the results
+  Result& context() {
+    return context_;
+  }
+
+  /// \return The counters to give to measure() and Result::setCounters(), or null if none can be
+  /// read
+  PerfCounters* counters() {
+    return counters_ && counters_->isAnyAvailable() ? counters_.get() : nullptr;
+  }
+
+  void add(const Result& result) {
+    if (json_) {
+      results_.push_back(result);
+      return;
+    }
+    if (!headerPrinted_) {
+      printf("%s\n", benchmark_.c_str());
+      for (const auto& field : context_.fields_) {
+        printf("  %s: %s\n", field.first.c_str(), field.second.text.c_str());
+      }
+      headerPrinted_ = true;
+    }
+    printf("  %-36s", result.name_.c_str());
+    for (const auto& field : result.fields_) {
+      printf(" %s=%s", field.first.c_str(), field.second.text.c_str());
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  void finish() {
+    if (!json_) {
+      return;
+    }
+    printf("{\n  \"benchmark\": \"%s\",\n  \"context\": ", escape(benchmark_).c_str());
+    printFields(context_, false);
+    printf(",\n  \"results\": [\n");
+    for (size_t i = 0; i < results_.size(); ++i) {
+      printf("    ");
+      printFields(results_[i], true);
+      printf(i + 1 < results_.size() ? ",\n" : "\n");
+    }
+    printf("  ]\n}\n");
+  }
+
+ private:
+  static std::string escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+      }
+      out += c;
+    }
+    return out;
+  }
+
+  static void printFields(const Result& result, bool withName) {
+    printf("{");
+    const char* separator = "";
+    if (withName) {
+      printf("\"name\": \"%s\"", escape(result.name_).c_str());
+      separator = ", ";
+    }
+    for (const auto& field : result.fields_) {
+      const std::string value =
+          field.second.isNumber ? field.second.text : "\"" + escape(field.second.text) + "\"";
+      printf("%s\"%s\": %s", separator, escape(field.first).c_str(), value.c_str());
+      separator = ", ";
+    }
+    printf("}");
+  }
+
+  std::string benchmark_;
+  Result context_;
+  bool json_;
+  bool headerPrinted_{false};
+  std::vector<Result> results_;
+  std::unique_ptr<PerfCounters> counters_;
+};
+
+/// Keeps the compiler from discarding a result that is otherwise unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "g"(value) : "memory");
+#else
+  static volatile T sink;
+  sink = value;
+  (void)sink;
+#endif
+}
+} // namespace Bench
+} // namespace TBE
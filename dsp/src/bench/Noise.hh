@@ -0,0 +1,31 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+namespace TBE {
+namespace Bench {
+/// Fill a buffer with uniform white noise in [-level, level]. Drawn from std::rand, so a run can
+/// be repeated with std::srand
+inline void fillNoise(float* buffer, size_t numSamples, float level = 1.f) {
+  for (size_t i = 0; i < numSamples; ++i) {
+    buffer[i] = level * (2.f * std::rand() / RAND_MAX - 1.f);
+  }
+}
+
+/// \return numSamples of uniform white noise in [-level, level], see fillNoise()
+inline std::vector<float> noise(size_t numSamples, float level = 1.f) {
+  std::vector<float> samples(numSamples);
+  fillNoise(samples.data(), numSamples, level);
+  return samples;
+}
+} // namespace Bench
+} // namespace TBE
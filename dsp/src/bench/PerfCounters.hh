@@ -0,0 +1,228 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+namespace TBE {
+namespace Bench {
+/// Hardware performance counters of the calling thread, read with perf_event_open on Linux.
+/// Each event is opened on its own, so the ones the CPU, the kernel or the permissions don't
+/// allow are simply unavailable while the others still count. Elsewhere nothing is available.
+///
+/// Counting is restricted to user space, which works with the default perf_event_paranoid
+/// setting of most distributions. Values are scaled up if the kernel had to multiplex the events.
+class PerfCounters {
+ public:
+  enum Event { CYCLES = 0, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, FP_ASSISTS, NUM_EVENTS };
+
+  PerfCounters() {
+    for (int event = 0; event < NUM_EVENTS; ++event) {
+      fds_[event] = -1;
+      values_[event] = NAN;
+    }
+#if defined(__linux__)
+    open(CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open(INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open(
+        L1D_MISSES,
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    open(
+        LLC_MISSES,
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    uint64_t fpAssistConfig = 0;
+    if (fpAssistEvent(&fpAssistConfig)) {
+      open(FP_ASSISTS, PERF_TYPE_RAW, fpAssistConfig);
+    } else if (status_.empty()) {
+      status_ = "no FP assist event for this CPU, set TBE_PERF_FP_ASSIST to a raw event";
+    }
+#else
+    status_ = "hardware counters are only read on Linux";
+#endif
+  }
+
+  ~PerfCounters() {
+#if defined(__linux__)
+    for (int event = 0; event < NUM_EVENTS; ++event) {
+      if (fds_[event] >= 0) {
+        close(fds_[event]);
+      }
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  static const char* eventName(Event event) {
+    static const char* kNames[NUM_EVENTS] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "fp_assists"};
+    return kNames[event];
+  }
+
+  bool isAvailable(Event event) const {
+    return fds_[event] >= 0;
+  }
+
+  bool isAnyAvailable() const {
+    for (int event = 0; event < NUM_EVENTS; ++event) {
+      if (isAvailable(static_cast<Event>(event))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// \return The names of the available events, or why there are none
+  std::string describe() const {
+    std::string available;
+    for (int event = 0; event < NUM_EVENTS; ++event) {
+      if (isAvailable(static_cast<Event>(event))) {
+        available += available.empty() ? "" : ",";
+        available += eventName(static_cast<Event>(event));
+      }
+    }
+    if (available.empty()) {
+      return "unavailable: " + status_;
+    }
+    return available;
+  }
+
+  /// Zero and start all available counters
+  void start() {
+#if defined(__linux__)
+    for (int event = 0; event < NUM_EVENTS; ++event) {
+      if (fds_[event] >= 0) {
+        ioctl(fds_[event], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds_[event], PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  /// Stop the counters and read them
+  void stop() {
+#if defined(__linux__)
+    for (int event = 0; event < NUM_EVENTS; ++event) {
+      if (fds_[event] >= 0) {
+        ioctl(fds_[event], PERF_EVENT_IOC_DISABLE, 0);
+      }
+    }
+    for (int event = 0; event < NUM_EVENTS; ++event) {
+      values_[event] = NAN;
+      uint64_t data[3];
+      if (fds_[event] < 0 || read(fds_[event], data, sizeof(data)) != sizeof(data)) {
+        continue;
+      }
+      // value, time enabled, time running
+      if (data[2] > 0) {
+        values_[event] = static_cast<double>(data[0]) * data[1] / data[2];
+      }
+    }
+#endif
+  }
+
+  /// \return The count between the last start() and stop(), NaN if the event is unavailable or
+  /// never got scheduled
+  double getValue(Event event) const {
+    return values_[event];
+  }
+
+ private:
+#if defined(__linux__)
+  void open(Event event, uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    fds_[event] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fds_[event] < 0 && status_.empty()) {
+      status_ = std::string(strerror(errno)) +
+          (errno == EACCES || errno == EPERM ? ", see /proc/sys/kernel/perf_event_paranoid" : "");
+    }
+  }
+
+  // There is no generic event for floating point assists, e.g. for denormal operands, and the raw
+  // event differs between cores. Intel cores from Sandy Bridge to Comet Lake count them with
+  // FP_ASSIST.ANY (event 0xCA, umask 0x1E), Ice Lake with ASSISTS.FP (event 0xC1, umask 0x02). On
+  // other CPUs a raw event can be given with the TBE_PERF_FP_ASSIST environment variable.
+  static bool fpAssistEvent(uint64_t* config) {
+    const char* env = getenv("TBE_PERF_FP_ASSIST");
+    if (env && *env) {
+      *config = strtoull(env, nullptr, 0);
+      return true;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int maxLeaf, vendor[3];
+    if (!__get_cpuid(0, &maxLeaf, &vendor[0], &vendor[2], &vendor[1]) ||
+        memcmp(vendor, "GenuineIntel", 12) != 0 || maxLeaf < 1) {
+      return false;
+    }
+    unsigned int signature, ebx, ecx, edx;
+    if (!__get_cpuid(1, &signature, &ebx, &ecx, &edx) || ((signature >> 8) & 0xf) != 6) {
+      return false;
+    }
+    const unsigned int model = ((signature >> 4) & 0xf) | (((signature >> 16) & 0xf) << 4);
+    static const unsigned int kFpAssistModels[] = {
+        0x2a, 0x2d, // Sandy Bridge
+        0x3a, 0x3e, // Ivy Bridge
+        0x3c, 0x3f, 0x45, 0x46, // Haswell
+        0x3d, 0x47, 0x4f, 0x56, // Broadwell
+        0x4e, 0x5e, 0x55, 0x8e, 0x9e, 0xa5, 0xa6, // Skylake to Comet Lake
+        0x66}; // Cannon Lake
+    static const unsigned int kIceLakeModels[] = {0x7d, 0x7e, 0x6a, 0x6c};
+    for (unsigned int fpAssistModel : kFpAssistModels) {
+      if (model == fpAssistModel) {
+        *config = 0x1eca;
+        return true;
+      }
+    }
+    for (unsigned int iceLakeModel : kIceLakeModels) {
+      if (model == iceLakeModel) {
+        *config = 0x02c1;
+        return true;
+      }
+    }
+#endif
+    return false;
+  }
+#endif
+
+  int fds_[NUM_EVENTS];
+  double values_[NUM_EVENTS];
+  // Why the first unavailable event couldn't be opened
+  std::string status_;
+};
+} // namespace Bench
+} // namespace TBE
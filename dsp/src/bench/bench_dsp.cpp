@@ -0,0 +1,398 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "../DSP.hh"
+#include "../Denormals.hh"
+#include "BenchUtils.hh"
+#include "Noise.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//
+// Micro-benchmarks of every FBDSP kernel and of the FIR paths, for each tier the CPU supports.
+// Run with --json to get a document that can be stored and compared between builds, see
+// BenchUtils.hh for the other options.
+//
+namespace TBE {
+namespace {
+const size_t kMaxBlockSize = 8192;
+const size_t kMaxChannels = 16;
+
+// Smallest normal float is ~1.2e-38, noise at this level keeps every product in the denormal range
+const float kDenormalLevel = 1e-39f;
+
+std::vector<size_t> blockSizes(const Bench::Options& options) {
+  if (options.quick) {
+    return {1, 64, 1024};
+  }
+  return {1, 4, 16, 64, 256, 1024, 4096, 8192};
+}
+
+std::vector<size_t> tapCounts(const Bench::Options& options) {
+  if (options.quick) {
+    return {8, 64, 512};
+  }
+  return {8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+}
+
+FBDSP makeDSP(CPU::Tier tier) {
+#ifdef TBE_STATIC_ISA
+  (void)tier;
+  return FBDSP{};
+#else
+  return FBDSP(tier);
+#endif
+}
+
+/// Inputs and outputs for every kernel, sized for the largest block
+struct Buffers {
+  Buffers()
+      : a(kMaxBlockSize * kMaxChannels),
+        b(kMaxBlockSize),
+        out(kMaxBlockSize * kMaxChannels),
+        int16(kMaxBlockSize),
+        int32(kMaxBlockSize),
+        int24(3 * kMaxBlockSize),
+        gains(kMaxChannels * kMaxChannels),
+        gainsEnd(kMaxChannels * kMaxChannels) {
+    Bench::fillNoise(a.data(), a.size(), 0.5f);
+    Bench::fillNoise(b.data(), b.size(), 0.5f);
+    Bench::fillNoise(gains.data(), gains.size(), 0.25f);
+    Bench::fillNoise(gainsEnd.data(), gainsEnd.size(), 0.25f);
+    for (size_t c = 0; c < kMaxChannels; ++c) {
+      inputs[c] = a.data() + c * kMaxBlockSize;
+      outputs[c] = out.data() + c * kMaxBlockSize;
+    }
+  }
+
+  std::vector<float> a;
+  std::vector<float> b;
+  std::vector<float> out;
+  std::vector<int16_t> int16;
+  std::vector<int32_t> int32;
+  std::vector<uint8_t> int24;
+  std::vector<float> gains;
+  std::vector<float> gainsEnd;
+  const float* inputs[kMaxChannels];
+  float* outputs[kMaxChannels];
+  uint32_t dither{1};
+};
+
+// Matrix kernels are measured on a third order Ambisonic field (16 channels) mixed to 8 outputs,
+// and the block-diagonal one on the per-order blocks of a 3OA rotation
+const size_t kMatrixInputs = 16;
+const size_t kMatrixOutputs = 8;
+const size_t kRotationBlocks[4] = {1, 3, 5, 7};
+
+struct Kernel {
+  const char* name;
+  void (*run)(const FBDSP& dsp, Buffers& buf, size_t n);
+};
+
+const Kernel kKernels[] = {
+    {"multiply",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.multiply(buf.a.data(), buf.b.data(), buf.out.data(), n);
+     }},
+    {"multiplyScalar",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.multiplyScalar(buf.a.data(), 0.5f, buf.out.data(), n);
+     }},
+    {"add",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.add(buf.a.data(), buf.b.data(), buf.out.data(), n);
+     }},
+    {"addScalar",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.addScalar(buf.a.data(), 0.5f, buf.out.data(), n);
+     }},
+    {"multiplyInputAndAdd",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.multiplyInputAndAdd(buf.a.data(), 0.5f, buf.b.data(), buf.out.data(), n);
+     }},
+    {"isBufferSilent",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       // Silent input, so the whole buffer is searched
+       Bench::doNotOptimize(dsp.isBufferSilent(buf.out.data() + kMaxBlockSize * 15, n));
+     }},
+    {"mixAndClip",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.mixAndClip(buf.a.data(), 0.5f, buf.b.data(), 0.9f, 1.f, buf.out.data(), n);
+     }},
+    {"peak",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       Bench::doNotOptimize(dsp.peak(buf.a.data(), n));
+     }},
+    {"sum",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       Bench::doNotOptimize(dsp.sum(buf.a.data(), n));
+     }},
+    {"sumOfSquares",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       Bench::doNotOptimize(dsp.sumOfSquares(buf.a.data(), n));
+     }},
+    {"dotProduct",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       Bench::doNotOptimize(dsp.dotProduct(buf.a.data(), buf.b.data(), n));
+     }},
+    {"minMax",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       float minValue, maxValue;
+       dsp.minMax(buf.a.data(), n, &minValue, &maxValue);
+       Bench::doNotOptimize(minValue + maxValue);
+     }},
+    {"convertInt16ToFloat",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.convertInt16ToFloat(buf.int16.data(), buf.out.data(), n);
+     }},
+    {"convertFloatToInt16",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.convertFloatToInt16(buf.a.data(), buf.int16.data(), n, nullptr);
+     }},
+    {"convertFloatToInt16Dither",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.convertFloatToInt16(buf.a.data(), buf.int16.data(), n, &buf.dither);
+     }},
+    {"convertInt24ToFloat",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.convertInt24ToFloat(buf.int24.data(), buf.out.data(), n);
+     }},
+    {"convertFloatToInt24",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.convertFloatToInt24(buf.a.data(), buf.int24.data(), n, nullptr);
+     }},
+    {"convertInt32ToFloat",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.convertInt32ToFloat(buf.int32.data(), buf.out.data(), n);
+     }},
+    {"convertFloatToInt32",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.convertFloatToInt32(buf.a.data(), buf.int32.data(), n);
+     }},
+    {"interleave",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.interleave(buf.inputs, 2, buf.out.data(), n);
+     }},
+    {"deinterleave",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.deinterleave(buf.a.data(), 2, buf.outputs, n);
+     }},
+    {"multiplyRamp",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.multiplyRamp(buf.a.data(), 0.2f, 0.8f, buf.out.data(), n);
+     }},
+    {"multiplyRampExp",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.multiplyRampExp(buf.a.data(), 0.2f, 0.8f, buf.out.data(), n);
+     }},
+    {"multiplyRampAndAdd",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.multiplyRampAndAdd(buf.a.data(), 0.2f, 0.8f, buf.b.data(), buf.out.data(), n);
+     }},
+    {"multiplyRampExpAndAdd",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.multiplyRampExpAndAdd(buf.a.data(), 0.2f, 0.8f, buf.b.data(), buf.out.data(), n);
+     }},
+    {"matrixMix",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.matrixMix(
+           buf.inputs, kMatrixInputs, buf.gains.data(), buf.outputs, kMatrixOutputs, n);
+     }},
+    {"matrixMixAdd",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.matrixMixAdd(
+           buf.inputs, kMatrixInputs, buf.gains.data(), buf.outputs, kMatrixOutputs, n);
+     }},
+    {"matrixMixBlockDiagonal",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.matrixMixBlockDiagonal(buf.inputs, buf.gains.data(), kRotationBlocks, 4, buf.outputs, n);
+     }},
+    {"matrixMixInterpolated",
+     [](const FBDSP& dsp, Buffers& buf, size_t n) {
+       dsp.matrixMixInterpolated(
+           buf.inputs,
+           kMatrixInputs,
+           buf.gains.data(),
+           buf.gainsEnd.data(),
+           buf.outputs,
+           kMatrixOutputs,
+           n);
+     }},
+};
+
+void benchKernels(const Bench::Options& options, Bench::Report& report) {
+  Buffers buf;
+  for (CPU::Tier tier : CPU::supportedTiers()) {
+    const FBDSP dsp = makeDSP(tier);
+    for (const Kernel& kernel : kKernels) {
+      const std::string name = std::string("FBDSP::") + kernel.name;
+      if (!Bench::selected(options, name)) {
+        continue;
+      }
+      for (size_t n : blockSizes(options)) {
+        // The output buffers are cleared first, so the accumulating kernels don't overflow
+        memset(buf.out.data(), 0, buf.out.size() * sizeof(float));
+        size_t numCalls = 0;
+        const double ns = Bench::measure(
+            [&]() { kernel.run(dsp, buf, n); }, options.minTimeMs, &numCalls, report.counters());
+        report.add(Bench::Result(name)
+                       .set("tier", CPU::tierName(tier))
+                       .set("block", static_cast<double>(n))
+                       .set("ns_per_call", ns)
+                       .set("ns_per_sample", ns / n)
+                       .setCounters(report.counters(), numCalls));
+      }
+    }
+  }
+}
+
+//
+// Sweeps the tap count and the block size for every FIR path: processLinear and process() with
+// the kernels of each tier
+//
+void benchFIR(const Bench::Options& options, Bench::Report& report) {
+  std::vector<float> input(kMaxBlockSize);
+  std::vector<float> output(kMaxBlockSize);
+  Bench::fillNoise(input.data(), input.size(), 0.5f);
+
+  struct Path {
+    std::string name;
+    std::string tier;
+    CPU::Tier cpuTier;
+    bool linear;
+  };
+  std::vector<Path> paths;
+  paths.push_back({"FIR::processLinear", "linear", CPU::Tier::SCALAR, true});
+  for (CPU::Tier tier : CPU::supportedTiers()) {
+    paths.push_back({"FIR::process", CPU::tierName(tier), tier, false});
+  }
+
+  for (size_t numTaps : tapCounts(options)) {
+    std::vector<float> ir(numTaps);
+    Bench::fillNoise(ir.data(), numTaps, 0.1f);
+
+    for (const Path& path : paths) {
+      if (!Bench::selected(options, path.name)) {
+        continue;
+      }
+      for (size_t n : blockSizes(options)) {
+        FIR fir(ir.data(), numTaps);
+        size_t numCalls = 0;
+        const double ns = Bench::measure(
+            [&]() {
+              if (path.linear) {
+                fir.processLinear(input.data(), output.data(), n);
+              } else {
+#ifdef TBE_STATIC_ISA
+                fir.process(input.data(), output.data(), n);
+#else
+                fir.process(path.cpuTier, input.data(), output.data(), n);
+#endif
+              }
+            },
+            options.minTimeMs,
+            &numCalls,
+            report.counters());
+        report.add(Bench::Result(path.name)
+                       .set("tier", path.tier)
+                       .set("taps", static_cast<double>(numTaps))
+                       .set("block", static_cast<double>(n))
+                       .set("ns_per_call", ns)
+                       .set("ns_per_sample", ns / n)
+                       .set("ns_per_tap_sample", ns / (n * numTaps))
+                       .setCounters(report.counters(), numCalls));
+      }
+    }
+  }
+}
+
+//
+// Reproduces the CPU spike at the end of a sound: a decayed tail in the denormal range costs
+// several times more than a normal signal on x86 unless FTZ/DAZ is set.
+//
+void benchDenormals(const Bench::Options& options, Bench::Report& report) {
+  const std::string name = "FIR::process denormals";
+  if (!Bench::selected(options, name)) {
+    return;
+  }
+
+  const size_t kNumTaps = 512;
+  const size_t kBlockSize = 512;
+  std::vector<float> ir(kNumTaps);
+  std::vector<float> normalInput(kBlockSize);
+  std::vector<float> denormalInput(kBlockSize);
+  std::vector<float> output(kBlockSize);
+
+  // Exponentially decaying IR, like the tail of a room or HRTF response
+  for (size_t i = 0; i < kNumTaps; ++i) {
+    ir[i] = (2.f * std::rand() / RAND_MAX - 1.f) * std::exp(-6.f * i / kNumTaps);
+  }
+  Bench::fillNoise(normalInput.data(), kBlockSize, 0.5f);
+  Bench::fillNoise(denormalInput.data(), kBlockSize, kDenormalLevel);
+
+  struct Case {
+    const char* input;
+    const float* samples;
+    bool protection;
+  };
+  const Case cases[] = {
+      {"normal", normalInput.data(), false},
+      {"denormal", denormalInput.data(), false},
+      {"denormal, protected", denormalInput.data(), true},
+  };
+
+  double normalNs = 0.0;
+  for (const Case& c : cases) {
+    FIR fir(ir.data(), kNumTaps);
+    fir.setDenormalProtection(c.protection);
+    size_t numCalls = 0;
+    const double ns = Bench::measure(
+        [&]() { fir.process(c.samples, output.data(), kBlockSize); },
+        options.minTimeMs,
+        &numCalls,
+        report.counters());
+    if (!c.protection && c.samples == normalInput.data()) {
+      normalNs = ns;
+    }
+    report.add(Bench::Result(name)
+                   .set("input", c.input)
+                   .set("taps", static_cast<double>(kNumTaps))
+                   .set("block", static_cast<double>(kBlockSize))
+                   .set("ns_per_call", ns)
+                   .set("slowdown", ns / normalNs)
+                   .setCounters(report.counters(), numCalls));
+  }
+}
+} // namespace
+} // namespace TBE
+
+int main(int argc, char** argv) {
+  TBE::Bench::Options options;
+  if (!TBE::Bench::parseOptions(argc, argv, &options)) {
+    return 1;
+  }
+
+  TBE::Bench::Report report("dsp-bench", options);
+  report.context()
+      .set("selected_tier", TBE::CPU::tierName(TBE::CPU::selectedTier()))
+      .set("ftz_daz", TBE::ScopedDenormalGuard::isSupported() ? "supported" : "flush fallback")
+#ifdef TBE_STATIC_ISA
+      .set("dispatch", "static")
+#else
+      .set("dispatch", "runtime")
+#endif
+      .set("min_time_ms", options.minTimeMs);
+
+  TBE::benchKernels(options, report);
+  TBE::benchFIR(options, report);
+  TBE::benchDenormals(options, report);
+  report.finish();
+  return 0;
+}
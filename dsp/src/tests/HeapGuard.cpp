@@ -0,0 +1,248 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "HeapGuard.hh"
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || \
+    __has_feature(memory_sanitizer)
+#define TBE_HEAP_GUARD_SANITIZED 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define TBE_HEAP_GUARD_SANITIZED 1
+#endif
+
+// The sanitizers replace the allocator of libc, and only intercept some of its internal names, so
+// with a sanitizer only new and delete are counted
+#if defined(__GLIBC__) && !defined(TBE_HEAP_GUARD_SANITIZED)
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#define TBE_HEAP_GUARD_LIBC 1
+
+// The allocator of glibc under its internal names, to forward to once a call has been counted
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+#endif
+
+namespace {
+// Per thread so allocations of gtest or other threads are not counted. Plain integers: these are
+// read and written from inside operator new and malloc and must not allocate themselves.
+thread_local int guardDepth = 0;
+thread_local size_t numAllocations = 0;
+thread_local size_t numDeallocations = 0;
+thread_local size_t numLocks = 0;
+
+void countAllocation() {
+  if (guardDepth > 0) {
+    ++numAllocations;
+  }
+}
+
+void countDeallocation(void* ptr) {
+  if (ptr && guardDepth > 0) {
+    ++numDeallocations;
+  }
+}
+
+#ifdef TBE_HEAP_GUARD_LIBC
+void* rawMalloc(size_t size) {
+  return __libc_malloc(size);
+}
+
+void rawFree(void* ptr) {
+  __libc_free(ptr);
+}
+#else
+void* rawMalloc(size_t size) {
+  return malloc(size);
+}
+
+void rawFree(void* ptr) {
+  free(ptr);
+}
+#endif
+
+void* allocate(size_t size) {
+  countAllocation();
+  void* ptr = rawMalloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void deallocate(void* ptr) {
+  countDeallocation(ptr);
+  rawFree(ptr);
+}
+
+#ifdef TBE_HEAP_GUARD_LIBC
+using LockFn = int (*)(pthread_mutex_t*);
+std::atomic<LockFn> realLock{nullptr};
+std::atomic<LockFn> realTryLock{nullptr};
+
+// The functions of libc are looked up on first use. Not with a function local static, whose guard
+// could itself end up locking a mutex
+LockFn nextLockFunction(std::atomic<LockFn>* cache, const char* name) {
+  LockFn fn = cache->load(std::memory_order_relaxed);
+  if (!fn) {
+    fn = reinterpret_cast<LockFn>(dlsym(RTLD_NEXT, name));
+    cache->store(fn, std::memory_order_relaxed);
+  }
+  return fn;
+}
+#endif
+} // namespace
+
+void* operator new(size_t size) {
+  return allocate(size);
+}
+
+void* operator new[](size_t size) {
+  return allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* ptr) noexcept {
+  deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  deallocate(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  deallocate(ptr);
+}
+
+#ifdef TBE_HEAP_GUARD_LIBC
+//
+// Definitions in the executable take precedence over those of libc, for the test code as well as
+// for the shared libraries it calls into.
+//
+extern "C" {
+void* malloc(size_t size) noexcept {
+  countAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+  countAllocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+  countAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+  countAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+  countAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+  countAllocation();
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  void* result = __libc_memalign(alignment, size);
+  if (!result) {
+    return ENOMEM;
+  }
+  *ptr = result;
+  return 0;
+}
+
+void free(void* ptr) noexcept {
+  countDeallocation(ptr);
+  __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+  if (guardDepth > 0) {
+    ++numLocks;
+  }
+  return nextLockFunction(&realLock, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex) noexcept {
+  if (guardDepth > 0) {
+    ++numLocks;
+  }
+  return nextLockFunction(&realTryLock, "pthread_mutex_trylock")(mutex);
+}
+}
+#endif
+
+namespace TBE {
+HeapGuard::HeapGuard()
+    : allocationsAtStart_(::numAllocations),
+      deallocationsAtStart_(::numDeallocations),
+      locksAtStart_(::numLocks) {
+  ++guardDepth;
+}
+
+HeapGuard::~HeapGuard() {
+  --guardDepth;
+}
+
+size_t HeapGuard::numAllocations() const {
+  return ::numAllocations - allocationsAtStart_;
+}
+
+size_t HeapGuard::numDeallocations() const {
+  return ::numDeallocations - deallocationsAtStart_;
+}
+
+size_t HeapGuard::numLocks() const {
+  return ::numLocks - locksAtStart_;
+}
+
+bool HeapGuard::interceptsLibc() {
+#ifdef TBE_HEAP_GUARD_LIBC
+  return true;
+#else
+  return false;
+#endif
+}
+} // namespace TBE
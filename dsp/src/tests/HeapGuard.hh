@@ -0,0 +1,68 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+namespace TBE {
+/// Counts the calls to the global operator new and delete made by this thread while it is alive,
+/// to assert that a real-time path such as process() never touches the general heap:
+///
+///   HeapGuard guard;
+///   renderer.process(...);
+///   EXPECT_EQ(guard.numAllocations(), 0);
+///
+/// With glibc, malloc, calloc, realloc, the aligned allocators and free are counted as well, and
+/// so are the pthread mutex locks underneath std::mutex, unless a sanitizer owns the allocator.
+/// See interceptsLibc().
+///
+/// Test only: HeapGuard.cpp replaces the global operators, and the C functions above, of the test
+/// binary it is linked into.
+class HeapGuard {
+ public:
+  HeapGuard();
+  ~HeapGuard();
+
+  HeapGuard(const HeapGuard&) = delete;
+  HeapGuard& operator=(const HeapGuard&) = delete;
+
+  /// \return The number of allocations made since this guard was created
+  size_t numAllocations() const;
+
+  /// \return The number of deallocations made since this guard was created
+  size_t numDeallocations() const;
+
+  /// \return The number of mutexes locked, or tried, since this guard was created
+  size_t numLocks() const;
+
+  /// \return True if the C allocation functions and mutexes are counted, not only new and delete
+  static bool interceptsLibc();
+
+ private:
+  size_t allocationsAtStart_;
+  size_t deallocationsAtStart_;
+  size_t locksAtStart_;
+};
+} // namespace TBE
+
+/// Fails the current test if statement allocates, frees or locks a mutex on this thread. The
+/// counts are taken before anything is reported, so gtest's own allocations don't show up.
+#define EXPECT_REALTIME_SAFE(statement)                                            \
+  do {                                                                             \
+    size_t rtAllocations, rtDeallocations, rtLocks;                                \
+    {                                                                              \
+      ::TBE::HeapGuard rtGuard;                                                    \
+      statement;                                                                   \
+      rtAllocations = rtGuard.numAllocations();                                    \
+      rtDeallocations = rtGuard.numDeallocations();                                \
+      rtLocks = rtGuard.numLocks();                                                \
+    }                                                                              \
+    EXPECT_EQ(rtAllocations, 0u) << "Allocated in: " #statement;                   \
+    EXPECT_EQ(rtDeallocations, 0u) << "Freed in: " #statement;                     \
+    EXPECT_EQ(rtLocks, 0u) << "Locked a mutex in: " #statement;                    \
+  } while (0)
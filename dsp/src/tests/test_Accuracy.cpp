@@ -0,0 +1,61 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <vector>
+#include "../DSP.hh"
+#include "../bench/Accuracy.hh"
+#include "../bench/Noise.hh"
+#include "gtest/gtest.h"
+
+namespace TBE {
+TEST(Accuracy, directConvolutionMatchesFIR) {
+  const size_t kNumSamples = 2000;
+  const size_t kNumTaps = 64;
+  const std::vector<float> input = Bench::noise(kNumSamples);
+  const std::vector<float> ir = Bench::noise(kNumTaps);
+  std::vector<float> output(kNumSamples);
+
+  FIR fir(ir.data(), kNumTaps);
+  fir.processLinear(input.data(), output.data(), kNumSamples);
+  const std::vector<double> reference =
+      Bench::directConvolution(input.data(), kNumSamples, ir.data(), kNumTaps);
+
+  const Bench::SignalError error =
+      Bench::compareSignals(reference.data(), output.data(), kNumSamples);
+  EXPECT_GT(error.snrDb, 120.0);
+  EXPECT_LT(error.maxError, 1e-5);
+
+  const Bench::SignalError exact =
+      Bench::compareSignals(reference.data(), reference.data(), kNumSamples);
+  EXPECT_EQ(exact.snrDb, Bench::kMaxSnrDb);
+  EXPECT_EQ(exact.maxError, 0.0);
+}
+
+TEST(Accuracy, interauralDifferences) {
+  const size_t kNumSamples = 4800;
+  const int kDelay = 7;
+  const std::vector<float> source = Bench::noise(kNumSamples);
+
+  // A source on the left: the right ear is quieter and later
+  std::vector<float> left(source);
+  std::vector<float> right(kNumSamples, 0.f);
+  for (size_t i = kDelay; i < kNumSamples; ++i) {
+    right[i] = 0.5f * source[i - kDelay];
+  }
+  EXPECT_NEAR(
+      Bench::interauralLevelDifferenceDb(left.data(), right.data(), kNumSamples), 6.02, 0.05);
+  EXPECT_NEAR(
+      Bench::interauralTimeDifference(left.data(), right.data(), kNumSamples, 48), kDelay, 0.1);
+
+  // And mirrored
+  EXPECT_NEAR(
+      Bench::interauralLevelDifferenceDb(right.data(), left.data(), kNumSamples), -6.02, 0.05);
+  EXPECT_NEAR(
+      Bench::interauralTimeDifference(right.data(), left.data(), kNumSamples, 48), -kDelay, 0.1);
+}
+} // namespace TBE
@@ -0,0 +1,137 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include "../Arena.hh"
+#include "../AudioBufferList.hh"
+#include "../DSP.hh"
+#include "HeapGuard.hh"
+#include "gtest/gtest.h"
+
+namespace TBE {
+namespace {
+// Written through so the allocation in the heap guard test can't be elided
+int* volatile gSink = nullptr;
+} // namespace
+
+TEST(Arena, alignedBumpAllocation) {
+  Arena arena(4096);
+  float* a = arena.allocate<float>(3);
+  float* b = arena.allocate<float>(100);
+  int* c = arena.allocate<int>(1);
+
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % kCacheLineSize, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % kCacheLineSize, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % kCacheLineSize, 0u);
+  EXPECT_EQ(reinterpret_cast<char*>(b) - reinterpret_cast<char*>(a), 64);
+  EXPECT_EQ(reinterpret_cast<char*>(c) - reinterpret_cast<char*>(b), 448);
+  EXPECT_EQ(arena.getUsed(), 64u + 448u + 64u);
+  EXPECT_TRUE(arena.contains(c));
+
+  arena.reset();
+  EXPECT_EQ(arena.getUsed(), 0u);
+  EXPECT_EQ(arena.allocate<float>(1), a);
+}
+
+TEST(Arena, externalBlock) {
+  alignas(64) static char block[1024];
+  Arena arena(block, sizeof(block));
+  EXPECT_EQ(arena.allocate<char>(10), block);
+  EXPECT_EQ(arena.getCapacity(), sizeof(block));
+}
+
+TEST(Arena, firMatchesHeapFir) {
+  const size_t kNumTaps = 64;
+  const size_t kNumSamples = 256;
+  std::vector<float> ir(kNumTaps);
+  std::vector<float> input(kNumSamples);
+  for (size_t i = 0; i < kNumTaps; ++i) {
+    ir[i] = 1.f / (1.f + i);
+  }
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    input[i] = (i % 7) - 3.f;
+  }
+
+  Arena arena(FIR::arenaSize(kNumTaps));
+  FIR arenaFir(ir.data(), kNumTaps, arena);
+  FIR heapFir(ir.data(), kNumTaps);
+  EXPECT_EQ(arena.getUsed(), FIR::arenaSize(kNumTaps));
+
+  std::vector<float> arenaOut(kNumSamples);
+  std::vector<float> heapOut(kNumSamples);
+  for (int block = 0; block < 4; ++block) {
+    arenaFir.process(input.data(), arenaOut.data(), kNumSamples);
+    heapFir.process(input.data(), heapOut.data(), kNumSamples);
+    for (size_t i = 0; i < kNumSamples; ++i) {
+      ASSERT_EQ(arenaOut[i], heapOut[i]);
+    }
+  }
+}
+
+TEST(Arena, firMemoryFootprint) {
+  const size_t kNumTaps = 100;
+  FIR heapFir(kNumTaps);
+  const MemoryFootprint heap = heapFir.memoryFootprint();
+  EXPECT_EQ(heap.coefficients.privateBytes, kNumTaps * sizeof(float));
+  EXPECT_EQ(heap.state.privateBytes, 2 * kNumTaps * sizeof(float) + sizeof(FIR));
+  EXPECT_EQ(heap.scratch.getTotal(), 0u);
+  EXPECT_EQ(heap.getShared(), 0u);
+
+  // From an arena, with the padding of the taps and the delay line
+  std::vector<float> ir(kNumTaps, 0.5f);
+  Arena arena(FIR::arenaSize(kNumTaps));
+  FIR arenaFir(ir.data(), kNumTaps, arena);
+  const MemoryFootprint fromArena = arenaFir.memoryFootprint();
+  EXPECT_EQ(fromArena.coefficients.privateBytes, Arena::sizeOf<float>(kNumTaps));
+  EXPECT_EQ(fromArena.getPrivate(), arena.getUsed() + sizeof(FIR));
+  EXPECT_EQ(fromArena.getTotal(), fromArena.getPrivate());
+}
+
+TEST(Arena, audioBufferList) {
+  Arena arena(AudioBufferList::arenaSize(300, 3));
+  {
+    AudioBufferList list(300, 3, arena);
+    EXPECT_EQ(arena.getUsed(), arena.getCapacity());
+    EXPECT_TRUE(arena.contains(list.getData()));
+    EXPECT_TRUE(arena.contains(list.getChannelDataToRead(2) + 299));
+    EXPECT_EQ(list.getChannelDataToRead(1) - list.getChannelDataToRead(0), list.getChannelStride());
+    EXPECT_EQ(list.getChannelDataToRead(2)[299], 0.f);
+  }
+  // The list did not free the block, it can be reused
+  arena.reset();
+  AudioBufferList other(300, 3, arena);
+  EXPECT_EQ(other.getChannelDataToRead(0)[0], 0.f);
+}
+
+TEST(HeapGuard, countsAllocations) {
+  HeapGuard guard;
+  gSink = new int(1);
+  delete gSink;
+  EXPECT_EQ(guard.numAllocations(), 1u);
+  EXPECT_EQ(guard.numDeallocations(), 1u);
+}
+
+TEST(HeapGuard, processDoesNotAllocate) {
+  const size_t kNumTaps = 128;
+  std::vector<float> ir(kNumTaps, 0.01f);
+  FIR fir(ir.data(), kNumTaps);
+  AudioBufferList in(512, 2);
+  AudioBufferList out(512, 2);
+
+  // Edge block sizes, including ones below a register width and above the number of taps
+  const int kBlockSizes[] = {1, 3, 8, 127, 128, 129, 512};
+  HeapGuard guard;
+  for (int numSamples : kBlockSizes) {
+    fir.process(in.getChannelDataToRead(0), out.getChannelDataToWrite(0), numSamples);
+    fir.processLinear(in.getChannelDataToRead(0), out.getChannelDataToWrite(0), numSamples);
+    out.sum(in);
+    out.zero();
+  }
+  EXPECT_EQ(guard.numAllocations(), 0u);
+}
+} // namespace TBE
@@ -0,0 +1,92 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <thread>
+#include "../AudioBlockQueue.hh"
+#include "HeapGuard.hh"
+#include "gtest/gtest.h"
+
+namespace TBE {
+TEST(AudioBlockQueue, fillAndDrain) {
+  AudioBlockQueue queue(3, 32, 2);
+  EXPECT_EQ(queue.getNumBlocks(), 3u);
+  EXPECT_EQ(queue.acquireRead(), nullptr);
+
+  AudioBufferList* written[3];
+  for (int i = 0; i < 3; ++i) {
+    written[i] = queue.acquireWrite();
+    ASSERT_NE(written[i], nullptr);
+    EXPECT_EQ(written[i]->getNumOfChannels(), 2);
+    EXPECT_EQ(written[i]->getSamplesPerChannel(), 32);
+    written[i]->getChannelDataToWrite(1)[31] = static_cast<float>(i);
+    queue.commitWrite();
+  }
+  EXPECT_EQ(queue.acquireWrite(), nullptr);
+  EXPECT_EQ(queue.getNumReadable(), 3u);
+
+  // Blocks come out in order and in place
+  for (int i = 0; i < 3; ++i) {
+    AudioBufferList* block = queue.acquireRead();
+    ASSERT_EQ(block, written[i]);
+    EXPECT_EQ(block->getChannelDataToRead(1)[31], static_cast<float>(i));
+    queue.releaseRead();
+  }
+  EXPECT_EQ(queue.acquireRead(), nullptr);
+
+  // And the slots are reused
+  EXPECT_EQ(queue.acquireWrite(), written[0]);
+}
+
+TEST(AudioBlockQueue, stress) {
+  const size_t kNumBlocks = 4;
+  const int32_t kNumSamples = 64;
+  const int32_t kNumChannels = 3;
+  const int kNumTransfers = 200000;
+  AudioBlockQueue queue(kNumBlocks, kNumSamples, kNumChannels);
+
+  std::thread producer([&queue]() {
+    for (int n = 0; n < kNumTransfers; ++n) {
+      AudioBufferList* block;
+      while ((block = queue.acquireWrite()) == nullptr) {
+        std::this_thread::yield();
+      }
+      for (int32_t c = 0; c < kNumChannels; ++c) {
+        float* data = block->getChannelDataToWrite(c);
+        for (int32_t s = 0; s < kNumSamples; ++s) {
+          data[s] = static_cast<float>(n + c + s);
+        }
+      }
+      queue.commitWrite();
+    }
+  });
+
+  // The consumer side must not allocate, it stands in for the audio thread
+  HeapGuard guard;
+  int errors = 0;
+  for (int n = 0; n < kNumTransfers; ++n) {
+    AudioBufferList* block;
+    while ((block = queue.acquireRead()) == nullptr) {
+      std::this_thread::yield();
+    }
+    EXPECT_LE(queue.getNumReadable(), kNumBlocks);
+    for (int32_t c = 0; c < kNumChannels; ++c) {
+      const float* data = block->getChannelDataToRead(c);
+      // Every sample of the block must come from the same, expected transfer
+      for (int32_t s = 0; s < kNumSamples; ++s) {
+        errors += data[s] != static_cast<float>(n + c + s);
+      }
+    }
+    queue.releaseRead();
+  }
+  const size_t numAllocations = guard.numAllocations();
+  producer.join();
+
+  EXPECT_EQ(errors, 0);
+  EXPECT_EQ(numAllocations, 0u);
+  EXPECT_EQ(queue.acquireRead(), nullptr);
+}
+} // namespace TBE
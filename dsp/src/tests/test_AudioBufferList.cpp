@@ -6,6 +6,7 @@
  */
 
 #include <cmath>
+#include <limits>
 #include "../AudioBufferList.hh"
 #include "gtest/gtest.h"
 
@@ -183,6 +184,18 @@ TEST_F(AudioBufferListTest, ChannelIsSilent) {
   EXPECT_FALSE(buffer.channelIsSilent(1));
   EXPECT_TRUE(buffer.channelIsSilent(0, buffer.getSamplesPerChannel() / 2));
   EXPECT_FALSE(buffer.channelIsSilent(1, buffer.getSamplesPerChannel() / 2));
+
+  // NaN is not silence, whether it fills the channel or is a single sample
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for (int i = 0; i < buffer.getSamplesPerChannel(); i++) {
+    buffer.getChannelDataToWrite(1)[i] = nan;
+  }
+  EXPECT_FALSE(buffer.channelIsSilent(1));
+  buffer.zero();
+  buffer.getChannelDataToWrite(0)[9] = nan;
+  EXPECT_FALSE(buffer.channelIsSilent(0));
+  EXPECT_TRUE(buffer.channelIsSilent(0, 9));
+  EXPECT_FALSE(buffer.channelsAreSilent());
 }
 
 TEST_F(AudioBufferListTest, getRMS) {
@@ -229,5 +242,123 @@ TEST_F(AudioBufferListTest, scale) {
     }
   }
 }
+TEST_F(AudioBufferListTest, alignedContiguousStorage) {
+  // 3OA, a 4 KiB channel would put every channel on the same cache sets without padding
+  const int32_t numSamples = 1024;
+  const int32_t numChannels = 16;
+  AudioBufferList buffer(numSamples, numChannels);
+
+  const int32_t stride = buffer.getChannelStride();
+  EXPECT_EQ(stride, AudioBufferList::channelStride(numSamples));
+  EXPECT_GE(stride, numSamples);
+  EXPECT_NE((stride * sizeof(float)) % 1024, 0u);
+
+  for (int32_t c = 0; c < numChannels; ++c) {
+    const float* channel = buffer.getChannelDataToRead(c);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(channel) % kCacheLineSize, 0u) << c;
+    EXPECT_EQ(channel, buffer.getChannelDataToRead(0) + c * stride) << c;
+  }
+
+  // Odd lengths are padded to whole cache lines
+  EXPECT_EQ(AudioBufferList::channelStride(1), 16);
+  EXPECT_EQ(AudioBufferList::channelStride(17), 32);
+  EXPECT_EQ(AudioBufferList::channelStride(256), 272);
+
+  for (int32_t c = 0; c < numChannels; ++c) {
+    for (int32_t s = 0; s < numSamples; ++s) {
+      buffer.getChannelDataToWrite(c)[s] = 1.f;
+    }
+  }
+  buffer.zero();
+  EXPECT_TRUE(buffer.channelsAreSilent());
+}
+
+TEST_F(AudioBufferListTest, externalBuffers) {
+  const int32_t numSamples = 37;
+  float** channels = new float*[2];
+  channels[0] = new float[numSamples];
+  channels[1] = new float[numSamples];
+
+  // Owned, released by the destructor as before
+  AudioBufferList buffer(channels, numSamples, 2, true);
+  EXPECT_EQ(buffer.getChannelStride(), 0);
+  EXPECT_EQ(buffer.getData(), channels);
+  buffer.zero();
+  EXPECT_TRUE(buffer.channelsAreSilent());
+}
+
+TEST_F(AudioBufferListTest, memoryFootprint) {
+  AudioBufferList owned(300, 3);
+  const MemoryFootprint ownedBytes = owned.memoryFootprint();
+  EXPECT_EQ(
+      ownedBytes.scratch.privateBytes, 3 * AudioBufferList::channelStride(300) * sizeof(float));
+  EXPECT_EQ(
+      ownedBytes.getPrivate(), AudioBufferList::arenaSize(300, 3) + sizeof(AudioBufferList));
+  EXPECT_EQ(ownedBytes.getShared(), 0u);
+  EXPECT_EQ(ownedBytes.coefficients.getTotal(), 0u);
+
+  // Channels of the caller are shared, only the list is private
+  float* channels[2] = {owned.getChannelDataToWrite(0), owned.getChannelDataToWrite(1)};
+  AudioBufferList borrowed(channels, 300, 2, false);
+  const MemoryFootprint borrowedBytes = borrowed.memoryFootprint();
+  EXPECT_EQ(borrowedBytes.getPrivate(), sizeof(AudioBufferList));
+  EXPECT_EQ(borrowedBytes.scratch.sharedBytes, 2 * 300 * sizeof(float));
+  EXPECT_EQ(borrowedBytes.state.sharedBytes, 2 * sizeof(float*));
+}
+
+TEST_F(AudioBufferListTest, views) {
+  AudioBufferList buffer(64, 4);
+  for (int32_t c = 0; c < 4; ++c) {
+    for (int32_t s = 0; s < 64; ++s) {
+      buffer.getChannelDataToWrite(c)[s] = static_cast<float>(100 * c + s);
+    }
+  }
+
+  AudioBufferView all = buffer.view();
+  EXPECT_EQ(all.getNumOfChannels(), 4);
+  EXPECT_EQ(all.getSamplesPerChannel(), 64);
+
+  // Slices share the samples of the list
+  AudioBufferView window = all.channels(1, 2).samples(10, 20);
+  EXPECT_EQ(window.getNumOfChannels(), 2);
+  EXPECT_EQ(window.getSamplesPerChannel(), 20);
+  EXPECT_EQ(window.getChannelData(0), buffer.getChannelDataToWrite(1) + 10);
+  EXPECT_EQ(window.samples(5, 1).getChannelData(1)[0], 215.f);
+
+  float* pointers[2];
+  window.getChannelPointers(pointers);
+  EXPECT_EQ(pointers[1], buffer.getChannelDataToWrite(2) + 10);
+
+  ConstAudioBufferView readOnly = window;
+  EXPECT_EQ(readOnly.getPeak(1), 229.f);
+  EXPECT_FALSE(readOnly.channelsAreSilent());
+
+  // Operations only touch the window
+  window.scale(2.f);
+  EXPECT_EQ(buffer.getChannelDataToRead(1)[9], 109.f);
+  EXPECT_EQ(buffer.getChannelDataToRead(1)[10], 220.f);
+  EXPECT_EQ(buffer.getChannelDataToRead(1)[30], 130.f);
+
+  window.zero();
+  EXPECT_TRUE(window.channelsAreSilent());
+  EXPECT_EQ(buffer.getChannelDataToRead(0)[10], 10.f);
+  EXPECT_EQ(buffer.getChannelDataToRead(2)[30], 230.f);
+
+  // Block-wise copy and sum between two lists, no pointer table needed
+  AudioBufferList other(64, 2);
+  other.view().copyFrom(buffer.view().channels(2, 2));
+  EXPECT_EQ(other.getChannelDataToRead(1)[63], 363.f);
+  other.view().samples(0, 32).sum(buffer.view().channels(0, 2).samples(32, 32));
+  EXPECT_EQ(other.getChannelDataToRead(0)[0], 200.f + 32.f);
+  EXPECT_EQ(other.getChannelDataToRead(1)[31], 331.f + 163.f);
+  EXPECT_EQ(other.getChannelDataToRead(1)[32], 332.f);
+
+  other.zero();
+  other.sum(buffer.view().channels(0, 2).samples(0, 16));
+  EXPECT_EQ(other.getChannelDataToRead(1)[5], 105.f);
+  EXPECT_EQ(other.getChannelDataToRead(1)[15], 0.f);
+  EXPECT_EQ(other.getChannelDataToRead(1)[16], 0.f);
+  EXPECT_FLOAT_EQ(other.view().samples(0, 16).getRMS(0), buffer.view().samples(0, 16).getRMS(0));
+}
 } // namespace SIMD
 } // namespace TBE
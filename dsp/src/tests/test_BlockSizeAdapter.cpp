@@ -0,0 +1,115 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdlib>
+#include <vector>
+#include "../BlockSizeAdapter.hh"
+#include "gtest/gtest.h"
+
+namespace TBE {
+namespace {
+// A stateful stand-in for a block engine: output 0 is the running sum of input 0 and output 1 the
+// difference of the two inputs. Only accepts blocks of its own size.
+class RunningSumEngine {
+ public:
+  explicit RunningSumEngine(int32_t blockSize) : blockSize_(blockSize) {}
+
+  void process(const ConstAudioBufferView& in, const AudioBufferView& out) {
+    EXPECT_EQ(in.getSamplesPerChannel(), blockSize_);
+    EXPECT_EQ(out.getSamplesPerChannel(), blockSize_);
+    ++numCalls_;
+    for (int32_t i = 0; i < out.getSamplesPerChannel(); ++i) {
+      sum_ += in.getChannelData(0)[i];
+      out.getChannelData(0)[i] = sum_;
+      out.getChannelData(1)[i] = in.getChannelData(0)[i] - in.getChannelData(1)[i];
+    }
+  }
+
+  int32_t blockSize_;
+  float sum_{0.f};
+  int numCalls_{0};
+};
+
+void fill(AudioBufferList& buffer) {
+  for (int32_t c = 0; c < buffer.getNumOfChannels(); ++c) {
+    for (int32_t i = 0; i < buffer.getSamplesPerChannel(); ++i) {
+      // Small integers keep the running sum exact
+      buffer.getChannelDataToWrite(c)[i] = static_cast<float>(std::rand() % 9 - 4);
+    }
+  }
+}
+} // namespace
+
+TEST(BlockSizeAdapter, variableCallbacks) {
+  const int32_t kLength = 4000;
+  const int32_t kBlockSizes[] = {1, 2, 64, 256, 1000};
+
+  AudioBufferList input(kLength, 2);
+  fill(input);
+
+  for (int32_t blockSize : kBlockSizes) {
+    RunningSumEngine reference(kLength);
+    AudioBufferList expected(kLength, 2);
+    reference.process(input.view(), expected.view());
+
+    RunningSumEngine engine(blockSize);
+    BlockSizeAdapter<RunningSumEngine> adapter(engine, 2, 2, blockSize);
+    EXPECT_FALSE(adapter.isPassthrough());
+    EXPECT_EQ(adapter.getLatency(), blockSize - 1);
+
+    // Host callbacks from 1 to 700 frames, changing every time, including empty ones
+    AudioBufferList output(kLength, 2);
+    int32_t offset = 0;
+    while (offset < kLength) {
+      const int32_t len = std::min(kLength - offset, std::rand() % 701);
+      adapter.process(input.view().samples(offset, len), output.view().samples(offset, len));
+      offset += len;
+    }
+
+    // The output is the unbuffered result, delayed by the latency
+    const int32_t latency = adapter.getLatency();
+    for (int32_t c = 0; c < 2; ++c) {
+      for (int32_t i = 0; i < kLength; ++i) {
+        const float want = i < latency ? 0.f : expected.getChannelDataToRead(c)[i - latency];
+        ASSERT_EQ(output.getChannelDataToRead(c)[i], want)
+            << "Block " << blockSize << " Channel " << c << " Idx " << i;
+      }
+    }
+    EXPECT_EQ(engine.numCalls_, kLength / blockSize);
+  }
+}
+
+TEST(BlockSizeAdapter, passthrough) {
+  const int32_t kBlockSize = 128;
+  const int32_t kHostSize = 512;
+  AudioBufferList input(kHostSize, 2);
+  AudioBufferList output(kHostSize, 2);
+  AudioBufferList expected(kHostSize, 2);
+  fill(input);
+
+  RunningSumEngine reference(kHostSize);
+  reference.process(input.view(), expected.view());
+
+  RunningSumEngine engine(kBlockSize);
+  BlockSizeAdapter<RunningSumEngine> adapter(engine, 2, 2, kBlockSize, kHostSize);
+  EXPECT_TRUE(adapter.isPassthrough());
+  EXPECT_EQ(adapter.getLatency(), 0);
+
+  adapter.process(input.view(), output.view());
+  EXPECT_EQ(engine.numCalls_, kHostSize / kBlockSize);
+  for (int32_t c = 0; c < 2; ++c) {
+    for (int32_t i = 0; i < kHostSize; ++i) {
+      ASSERT_EQ(output.getChannelDataToRead(c)[i], expected.getChannelDataToRead(c)[i]);
+    }
+  }
+
+  // A host size that doesn't line up falls back to buffering
+  BlockSizeAdapter<RunningSumEngine> buffered(engine, 2, 2, kBlockSize, 480);
+  EXPECT_FALSE(buffered.isPassthrough());
+  EXPECT_EQ(buffered.getLatency(), kBlockSize - 1);
+}
+} // namespace TBE
@@ -0,0 +1,92 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <thread>
+#include "../DeadlineMonitor.hh"
+#include "HeapGuard.hh"
+#include "gtest/gtest.h"
+
+namespace TBE {
+namespace {
+const int kNumBins = DeadlineStats::kNumBins;
+} // namespace
+
+TEST(DeadlineMonitor, histogramBins) {
+  EXPECT_EQ(DeadlineStats::getBin(0.0), 0);
+  EXPECT_EQ(DeadlineStats::getBin(1.0 / 1024.0), 0);
+  EXPECT_EQ(DeadlineStats::getBin(1.0 / 256.0), 1);
+  EXPECT_EQ(DeadlineStats::getBin(1.0), 33);
+  EXPECT_EQ(DeadlineStats::getBin(0.99), 32);
+  EXPECT_EQ(DeadlineStats::getBin(3.99), kNumBins - 2);
+  EXPECT_EQ(DeadlineStats::getBin(4.0), kNumBins - 1);
+  EXPECT_EQ(DeadlineStats::getBin(1e9), kNumBins - 1);
+
+  // Every bin holds the loads from its lower bound up to the next one
+  for (int bin = 1; bin < kNumBins; ++bin) {
+    const double lower = DeadlineStats::getBinLowerBound(bin);
+    EXPECT_EQ(DeadlineStats::getBin(lower * 1.0001), bin) << "Bin " << bin;
+    EXPECT_EQ(DeadlineStats::getBin(lower * 0.9999), bin - 1) << "Bin " << bin;
+  }
+}
+
+TEST(DeadlineMonitor, recordLoads) {
+  // 480 samples at 48 kHz are a 10 ms deadline
+  DeadlineMonitor monitor(48000.f);
+  const uint64_t kMs = 1000000;
+  const uint64_t kElapsedNs[] = {1 * kMs, 2 * kMs, 5 * kMs, 9 * kMs, 11 * kMs, 30 * kMs};
+
+  HeapGuard guard;
+  for (uint64_t elapsed : kElapsedNs) {
+    monitor.record(elapsed, 480);
+  }
+  EXPECT_EQ(guard.numAllocations(), 0u);
+
+  DeadlineStats stats = monitor.getStats();
+  EXPECT_EQ(stats.numCalls, 6u);
+  EXPECT_EQ(stats.numOverruns, 2u);
+  EXPECT_EQ(stats.worstNs, 30 * kMs);
+  EXPECT_NEAR(stats.worstLoad, 3.0, 1e-9);
+  EXPECT_NEAR(stats.getMeanLoad(), 5.8 / 6.0, 1e-9);
+  EXPECT_EQ(stats.getCallsAbove(0.8), 3u);
+  EXPECT_EQ(stats.getCallsAbove(1.0), 2u);
+  uint64_t total = 0;
+  for (int bin = 0; bin < kNumBins; ++bin) {
+    total += stats.histogram[bin];
+  }
+  EXPECT_EQ(total, 6u);
+  EXPECT_EQ(stats.histogram[DeadlineStats::getBin(0.5)], 1u);
+
+  // The deadline follows the length of each call
+  monitor.reset();
+  monitor.record(11 * kMs, 960);
+  stats = monitor.getStats();
+  EXPECT_EQ(stats.numCalls, 1u);
+  EXPECT_EQ(stats.numOverruns, 0u);
+  EXPECT_NEAR(stats.worstLoad, 0.55, 1e-9);
+}
+
+TEST(DeadlineMonitor, disabled) {
+  DeadlineMonitor monitor;
+  EXPECT_FALSE(monitor.isEnabled());
+  monitor.begin();
+  monitor.end(256);
+  monitor.record(1000, 256);
+  EXPECT_EQ(monitor.getStats().numCalls, 0u);
+
+  monitor.setSampleRate(44100.f);
+  EXPECT_TRUE(monitor.isEnabled());
+  monitor.begin();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  monitor.end(44100);
+  const DeadlineStats stats = monitor.getStats();
+  EXPECT_EQ(stats.numCalls, 1u);
+  EXPECT_GE(stats.worstNs, 2000000u);
+  EXPECT_GT(stats.worstLoad, 0.0);
+  EXPECT_LT(stats.worstLoad, 1.0);
+}
+} // namespace TBE
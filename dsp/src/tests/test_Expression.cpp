@@ -0,0 +1,78 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "../Expression.hh"
+#include "../bench/Noise.hh"
+#include "gtest/gtest.h"
+
+#ifdef __ARM_NEON
+#include "../RegOpsNeon.hh"
+using TestReg = float32x4_t;
+#else
+#include "../RegOpsSSE.hh"
+using TestReg = __m128;
+#endif
+
+namespace TBE {
+namespace {
+// Not a multiple of the register width so the scalar tail is covered too
+const size_t kNumSamples = 37;
+
+} // namespace
+
+TEST(Expression, arithmetic) {
+  float a[kNumSamples], b[kNumSamples], outReg[kNumSamples], outScalar[kNumSamples];
+  Bench::fillNoise(a, kNumSamples, 2.f);
+  Bench::fillNoise(b, kNumSamples, 2.f);
+
+  using namespace Expr;
+  const auto expr = (Input(a) - 0.5f) * Input(b) + 2.f * Input(a) - Input(b);
+  evaluate<TestReg>(expr, outReg, kNumSamples);
+  evaluate<float>(expr, outScalar, kNumSamples);
+
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    const float expected = (a[i] - 0.5f) * b[i] + 2.f * a[i] - b[i];
+    EXPECT_NEAR(outReg[i], expected, 1e-6f) << i;
+    EXPECT_NEAR(outScalar[i], expected, 1e-6f) << i;
+  }
+}
+
+TEST(Expression, minMaxAbsClip) {
+  float a[kNumSamples], b[kNumSamples], out[kNumSamples];
+  Bench::fillNoise(a, kNumSamples, 2.f);
+  Bench::fillNoise(b, kNumSamples, 2.f);
+
+  using namespace Expr;
+  evaluate<TestReg>(max(abs(Input(a)), Input(b)), out, kNumSamples);
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    EXPECT_EQ(out[i], std::max(std::abs(a[i]), b[i])) << i;
+  }
+
+  evaluate<TestReg>(min(Input(a), Input(b)), out, kNumSamples);
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    EXPECT_EQ(out[i], std::min(a[i], b[i])) << i;
+  }
+
+  evaluate<TestReg>(clip(Input(a), -1.f, 0.5f), out, kNumSamples);
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    EXPECT_EQ(out[i], std::min(std::max(a[i], -1.f), 0.5f)) << i;
+  }
+}
+
+TEST(Expression, inPlace) {
+  float a[kNumSamples], b[kNumSamples], original[kNumSamples];
+  Bench::fillNoise(a, kNumSamples, 2.f);
+  Bench::fillNoise(b, kNumSamples, 2.f);
+  std::copy(a, a + kNumSamples, original);
+
+  using namespace Expr;
+  evaluate<TestReg>(Input(a) * Input(b) + Input(a), a, kNumSamples);
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    EXPECT_FLOAT_EQ(a[i], original[i] * b[i] + original[i]) << i;
+  }
+}
+} // namespace TBE
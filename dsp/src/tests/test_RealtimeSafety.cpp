@@ -0,0 +1,143 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <mutex>
+#include <vector>
+#include "../AudioBufferList.hh"
+#include "../CpuFeatures.hh"
+#include "../DSP.hh"
+#include "../bench/Noise.hh"
+#include "HeapGuard.hh"
+#include "gtest/gtest.h"
+
+//
+// The process paths must neither allocate nor lock: on the audio thread either can block for an
+// unbounded time. Each path runs under EXPECT_REALTIME_SAFE for block sizes around the register
+// widths and the tap count. FIR::process covers every tier supported by this CPU; the
+// AudioBufferList ops use the selected tier, which ctest varies with TBE_DSP_TIER.
+//
+namespace TBE {
+namespace {
+const int32_t kMaxBlockSize = 1024;
+const int32_t kEdgeBlockSizes[] = {
+    1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129, 255, 256, 257, 1023,
+    kMaxBlockSize};
+
+void* volatile gSink;
+volatile float gFloatSink;
+volatile bool gBoolSink;
+
+void fillNoise(AudioBufferList& buffer) {
+  for (int32_t c = 0; c < buffer.getNumOfChannels(); ++c) {
+    Bench::fillNoise(buffer.getChannelDataToWrite(c), buffer.getSamplesPerChannel());
+  }
+}
+} // namespace
+
+TEST(RealtimeSafety, guardDetectsViolations) {
+  size_t allocations, deallocations, locks;
+  {
+    HeapGuard guard;
+    gSink = malloc(16);
+    free(gSink);
+    std::mutex mutex;
+    mutex.lock();
+    mutex.unlock();
+    allocations = guard.numAllocations();
+    deallocations = guard.numDeallocations();
+    locks = guard.numLocks();
+  }
+  if (!HeapGuard::interceptsLibc()) {
+    return;
+  }
+  EXPECT_EQ(allocations, 1u);
+  EXPECT_EQ(deallocations, 1u);
+  EXPECT_EQ(locks, 1u);
+}
+
+TEST(RealtimeSafety, FIR) {
+  const size_t kTapCounts[] = {8, 9, 17, 100, 512};
+  AudioBufferList input(kMaxBlockSize, 1);
+  AudioBufferList output(kMaxBlockSize, 1);
+  fillNoise(input);
+  const float* in = input.getChannelDataToRead(0);
+  float* out = output.getChannelDataToWrite(0);
+
+  for (size_t numTaps : kTapCounts) {
+    // One filter per path: processLinear keeps its delay line in another order than process()
+    std::vector<float> ir(numTaps, 0.01f);
+    FIR fir(ir.data(), numTaps);
+    FIR linear(ir.data(), numTaps);
+    for (int32_t numSamples : kEdgeBlockSizes) {
+      EXPECT_REALTIME_SAFE(fir.process(in, out, numSamples));
+      EXPECT_REALTIME_SAFE(linear.processLinear(in, out, numSamples));
+      fir.setDenormalProtection(!fir.getDenormalProtection());
+      linear.setDenormalProtection(!linear.getDenormalProtection());
+    }
+
+#ifndef TBE_STATIC_ISA
+    for (CPU::Tier tier : CPU::supportedTiers()) {
+      FIR tierFir(ir.data(), numTaps);
+      for (int32_t numSamples : kEdgeBlockSizes) {
+        EXPECT_REALTIME_SAFE(tierFir.process(tier, in, out, numSamples));
+        tierFir.setDenormalProtection(!tierFir.getDenormalProtection());
+      }
+    }
+#endif
+  }
+}
+
+TEST(RealtimeSafety, AudioBufferList) {
+  for (int32_t numSamples : kEdgeBlockSizes) {
+    AudioBufferList a(numSamples, 4);
+    AudioBufferList b(numSamples, 4);
+    fillNoise(a);
+    fillNoise(b);
+    float* pointers[4];
+    EXPECT_REALTIME_SAFE(a.sum(b));
+    EXPECT_REALTIME_SAFE(a.sum(b, 1, 0, 2, numSamples));
+    EXPECT_REALTIME_SAFE(a.sum(b.view()));
+    EXPECT_REALTIME_SAFE(a.scale(0.5f));
+    EXPECT_REALTIME_SAFE(gFloatSink = a.getPeak(1) + a.getRMS(2));
+    EXPECT_REALTIME_SAFE(gBoolSink = a.channelsAreSilent());
+    EXPECT_REALTIME_SAFE(a.zero());
+
+    // Views of the lists, and of a part of them
+    EXPECT_REALTIME_SAFE(a.view().copyFrom(b.view()));
+    EXPECT_REALTIME_SAFE(a.view().channels(1, 2).sum(b.view().channels(0, 2)));
+    EXPECT_REALTIME_SAFE(a.view().samples(0, numSamples / 2).scale(2.f));
+    EXPECT_REALTIME_SAFE(a.view().getChannelPointers(pointers));
+    EXPECT_REALTIME_SAFE(gFloatSink = a.view().getPeak(0));
+    EXPECT_REALTIME_SAFE(a.view().zero());
+  }
+}
+
+TEST(RealtimeSafety, kernelsOfEveryTier) {
+  AudioBufferList a(kMaxBlockSize, 2);
+  AudioBufferList b(kMaxBlockSize, 2);
+  fillNoise(a);
+  fillNoise(b);
+  float* x = a.getChannelDataToWrite(0);
+  float* y = a.getChannelDataToWrite(1);
+  float* z = b.getChannelDataToWrite(0);
+
+  for (CPU::Tier tier : CPU::supportedTiers()) {
+#ifdef TBE_STATIC_ISA
+    (void)tier;
+    const FBDSP dsp;
+#else
+    const FBDSP dsp(tier);
+#endif
+    for (int32_t n : kEdgeBlockSizes) {
+      EXPECT_REALTIME_SAFE(dsp.add(x, y, z, n));
+      EXPECT_REALTIME_SAFE(dsp.multiplyInputAndAdd(x, 0.5f, y, z, n));
+      EXPECT_REALTIME_SAFE(gBoolSink = dsp.isBufferSilent(x, n));
+    }
+  }
+}
+} // namespace TBE
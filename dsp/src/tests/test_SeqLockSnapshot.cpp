@@ -0,0 +1,75 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <thread>
+#include "../SeqLockSnapshot.hh"
+#include "HeapGuard.hh"
+#include "gtest/gtest.h"
+
+namespace TBE {
+namespace {
+// Every field is derived from the first, so a torn copy is easy to spot
+struct Counters {
+  uint64_t count;
+  uint64_t twice;
+  uint64_t values[30];
+  float last;
+};
+} // namespace
+
+TEST(SeqLockSnapshot, initiallyZero) {
+  SeqLockSnapshot<Counters> snapshot;
+  const Counters counters = snapshot.read();
+  EXPECT_EQ(counters.count, 0u);
+  EXPECT_EQ(counters.twice, 0u);
+  EXPECT_EQ(counters.values[29], 0u);
+  EXPECT_EQ(counters.last, 0.f);
+}
+
+TEST(SeqLockSnapshot, readersNeverSeeTornValues) {
+  const uint64_t kNumPublishes = 200000;
+  SeqLockSnapshot<Counters> snapshot;
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> numTorn{0};
+  std::atomic<uint64_t> numBackwards{0};
+
+  std::thread reader([&]() {
+    uint64_t previous = 0;
+    while (!done.load()) {
+      const Counters counters = snapshot.read();
+      bool consistent = counters.twice == 2 * counters.count &&
+          counters.last == static_cast<float>(counters.count % 1000);
+      for (int i = 0; i < 30; ++i) {
+        consistent = consistent && counters.values[i] == counters.count + i;
+      }
+      numTorn += consistent || counters.count == 0 ? 0 : 1;
+      numBackwards += counters.count < previous ? 1 : 0;
+      previous = counters.count;
+    }
+  });
+
+  Counters counters = {};
+  HeapGuard guard;
+  for (uint64_t count = 1; count <= kNumPublishes; ++count) {
+    counters.count = count;
+    counters.twice = 2 * count;
+    for (int i = 0; i < 30; ++i) {
+      counters.values[i] = count + i;
+    }
+    counters.last = static_cast<float>(count % 1000);
+    snapshot.publish(counters);
+  }
+  EXPECT_EQ(guard.numAllocations(), 0u);
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(numTorn.load(), 0u);
+  EXPECT_EQ(numBackwards.load(), 0u);
+  EXPECT_EQ(snapshot.read().count, kNumPublishes);
+}
+} // namespace TBE
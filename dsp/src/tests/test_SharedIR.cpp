@@ -0,0 +1,93 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include "../Arena.hh"
+#include "../DSP.hh"
+#include "../SharedIR.hh"
+#include "../bench/Noise.hh"
+#include "gtest/gtest.h"
+
+namespace TBE {
+TEST(SharedIR, reversedAndAligned) {
+  const float ir[5] = {1.f, 2.f, 3.f, 4.f, 5.f};
+  SharedIR::Ptr taps = SharedIR::get(ir, 5, 8);
+  ASSERT_EQ(taps->getNumTaps(), 8u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(taps->getTaps()) % kCacheLineSize, 0u);
+  EXPECT_EQ(taps->getSize(), kCacheLineSize);
+
+  // Padded in front once reversed, as FIR stores its taps
+  const float expected[8] = {0.f, 0.f, 0.f, 5.f, 4.f, 3.f, 2.f, 1.f};
+  for (size_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(taps->getTaps()[i], expected[i]) << i;
+  }
+}
+
+TEST(SharedIR, sharedByContent) {
+  const std::vector<float> ir = Bench::noise(64);
+  const std::vector<float> copy(ir);
+  std::vector<float> other(ir);
+  other[63] += 1.f;
+  const size_t numStored = SharedIR::numStored();
+
+  SharedIR::Ptr a = SharedIR::get(ir.data(), ir.size(), ir.size());
+  SharedIR::Ptr b = SharedIR::get(copy.data(), copy.size(), copy.size());
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(SharedIR::numStored(), numStored + 1);
+
+  // A different sample or tap count is a different IR
+  SharedIR::Ptr c = SharedIR::get(other.data(), other.size(), other.size());
+  SharedIR::Ptr d = SharedIR::get(ir.data(), ir.size(), 2 * ir.size());
+  EXPECT_NE(a, c);
+  EXPECT_NE(a, d);
+  EXPECT_EQ(SharedIR::numStored(), numStored + 3);
+
+  // Released with the last user
+  a.reset();
+  EXPECT_EQ(SharedIR::numStored(), numStored + 3);
+  b.reset();
+  c.reset();
+  d.reset();
+  EXPECT_EQ(SharedIR::numStored(), numStored);
+}
+
+TEST(SharedIR, firMatchesPrivateTaps) {
+  const size_t kNumTaps = 100;
+  const size_t kNumSamples = 256;
+  const std::vector<float> ir = Bench::noise(kNumTaps);
+  const std::vector<float> input = Bench::noise(kNumSamples);
+
+  FIR privateFir(ir.data(), kNumTaps);
+  SharedIR::Ptr taps = SharedIR::get(ir.data(), kNumTaps, kNumTaps);
+  FIR heapFir(taps);
+  Arena arena(FIR::sharedIRArenaSize(kNumTaps));
+  FIR arenaFir(taps, arena);
+  EXPECT_EQ(arena.getUsed(), FIR::sharedIRArenaSize(kNumTaps));
+  EXPECT_EQ(taps.use_count(), 3);
+
+  std::vector<float> expected(kNumSamples);
+  std::vector<float> heapOut(kNumSamples);
+  std::vector<float> arenaOut(kNumSamples);
+  for (int block = 0; block < 3; ++block) {
+    privateFir.process(input.data(), expected.data(), kNumSamples);
+    heapFir.process(input.data(), heapOut.data(), kNumSamples);
+    arenaFir.processLinear(input.data(), arenaOut.data(), kNumSamples);
+    for (size_t i = 0; i < kNumSamples; ++i) {
+      ASSERT_EQ(heapOut[i], expected[i]);
+      ASSERT_NEAR(arenaOut[i], expected[i], 1e-5f);
+    }
+  }
+
+  // Only the delay line is private
+  const MemoryFootprint footprint = heapFir.memoryFootprint();
+  EXPECT_EQ(footprint.coefficients.privateBytes, 0u);
+  EXPECT_EQ(footprint.coefficients.sharedBytes, taps->getSize());
+  EXPECT_EQ(footprint.state.privateBytes, 2 * kNumTaps * sizeof(float) + sizeof(FIR));
+  EXPECT_EQ(arenaFir.memoryFootprint().getPrivate(), arena.getUsed() + sizeof(FIR));
+}
+} // namespace TBE
@@ -6,10 +6,158 @@
  */
 
 #include "../DSP.hh"
+#include "../Denormals.hh"
 #include "../Internal.hh"
 #include "gtest/gtest.h"
 
+#include <cfloat>
+#include <limits>
+
 namespace TBE {
+TEST(CpuFeatures, Tiers) {
+  const CPU::Features& f = CPU::features();
+  EXPECT_EQ(&f, &CPU::features());
+  // The extensions of the AVX family are only reported along with usable AVX
+  if (f.avx2 || f.fma || f.f16c) {
+    EXPECT_TRUE(f.avx);
+  }
+
+  EXPECT_TRUE(CPU::tierSupported(CPU::bestTier()));
+  EXPECT_TRUE(CPU::tierSupported(CPU::selectedTier()));
+  EXPECT_EQ(CPU::avxAvailable(), CPU::tierSupported(CPU::Tier::AVX));
+  EXPECT_STREQ(CPU::tierName(CPU::Tier::AVX), "avx");
+
+  // The tier is resolved by now, so it can no longer be pinned
+  EXPECT_FALSE(CPU::setTierOverride(CPU::Tier::SCALAR));
+}
+
+#ifndef TBE_STATIC_ISA
+TEST(CpuFeatures, EveryTierMatchesScalar) {
+  const size_t numSamples = 37;
+  float inA[numSamples], inB[numSamples], expected[numSamples], out[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    inA[i] = static_cast<float>(i) * 0.5f - 3.f;
+    inB[i] = 1.f / static_cast<float>(i + 1);
+  }
+
+  FBDSP scalar(CPU::Tier::SCALAR);
+  scalar.multiply(inA, inB, expected, numSamples);
+  const float expectedPeak = scalar.peak(inA, numSamples);
+
+  const CPU::Tier tiers[] = {CPU::Tier::SSE, CPU::Tier::AVX, CPU::Tier::NEON};
+  for (CPU::Tier tier : tiers) {
+    if (!CPU::tierSupported(tier)) {
+      continue;
+    }
+    FBDSP dsp(tier);
+    dsp.multiply(inA, inB, out, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(out[i], expected[i]) << CPU::tierName(tier) << " Idx " << i;
+    }
+    EXPECT_EQ(dsp.peak(inA, numSamples), expectedPeak) << CPU::tierName(tier);
+  }
+
+  // Every tier reports a NaN, whichever lane and accumulator it lands in
+  for (size_t position = 0; position < numSamples; ++position) {
+    const float saved = inA[position];
+    inA[position] = std::numeric_limits<float>::quiet_NaN();
+    EXPECT_TRUE(std::isnan(scalar.peak(inA, numSamples))) << position;
+    for (CPU::Tier tier : tiers) {
+      if (CPU::tierSupported(tier)) {
+        EXPECT_TRUE(std::isnan(FBDSP(tier).peak(inA, numSamples)))
+            << CPU::tierName(tier) << " Position " << position;
+      }
+    }
+    inA[position] = saved;
+  }
+}
+
+TEST(CpuFeatures, EveryFIRTierMatchesLinear) {
+  const size_t numTaps = 24;
+  const size_t numSamples = 150;
+  float ir[numTaps], input[numSamples], expected[numSamples], out[numSamples];
+  for (size_t i = 0; i < numTaps; ++i) {
+    ir[i] = 1.f / static_cast<float>(i + 2);
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    input[i] = static_cast<float>(i % 11) - 5.f;
+  }
+
+  const CPU::Tier tiers[] = {CPU::Tier::SCALAR, CPU::Tier::SSE, CPU::Tier::AVX, CPU::Tier::NEON};
+  for (CPU::Tier tier : tiers) {
+    if (!CPU::tierSupported(tier)) {
+      continue;
+    }
+    FIR fir(ir, numTaps);
+    FIR linear(ir, numTaps);
+    // Two blocks so the second one starts from the delay line of the first
+    for (int block = 0; block < 2; ++block) {
+      linear.processLinear(input, expected, numSamples);
+      fir.process(tier, input, out, numSamples);
+      for (size_t i = 0; i < numSamples; ++i) {
+        ASSERT_NEAR(out[i], expected[i], 1e-4f) << CPU::tierName(tier) << " Idx " << i;
+      }
+    }
+  }
+}
+#endif
+
+TEST(FBDSP, SharedTable) {
+  const FBDSP& shared = FBDSP::shared();
+  EXPECT_EQ(&shared, &FBDSP::shared());
+
+#ifndef TBE_STATIC_ISA
+  // A default constructed FBDSP is a copy of the shared table
+  FBDSP dsp;
+  EXPECT_NE(shared.multiply, nullptr);
+  EXPECT_EQ(dsp.multiply, shared.multiply);
+  EXPECT_EQ(dsp.matrixMixInterpolated, shared.matrixMixInterpolated);
+#endif
+
+  const float in[3] = {1.f, 2.f, 3.f};
+  float out[3];
+  shared.multiplyScalar(in, 2.f, out, 3);
+  EXPECT_EQ(out[2], 6.f);
+}
+
+TEST(FBDSP, AlignedAndUnalignedBuffers) {
+  const size_t numSamples = 45;
+  // One spare line so the buffers can be offset from their alignment
+  alignas(64) float inA[numSamples + 16];
+  alignas(64) float inB[numSamples + 16];
+  alignas(64) float out[numSamples + 16];
+  for (size_t i = 0; i < numSamples + 16; ++i) {
+    inA[i] = static_cast<float>(i) - 20.f;
+    inB[i] = 0.5f * static_cast<float>(i);
+  }
+
+  const FBDSP& dsp = FBDSP::shared();
+  const size_t offsets[] = {0, 1, 4, 8};
+  for (size_t offset : offsets) {
+    const float* a = inA + offset;
+    const float* b = inB + offset;
+    float* o = out + offset;
+
+    dsp.add(a, b, o, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(o[i], a[i] + b[i]) << offset << ", " << i;
+    }
+    dsp.multiply(a, b, o, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(o[i], a[i] * b[i]) << offset << ", " << i;
+    }
+    dsp.multiplyInputAndAdd(a, 3.f, b, o, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(o[i], a[i] * 3.f + b[i]) << offset << ", " << i;
+    }
+    dsp.multiplyScalar(a, -2.f, o, numSamples);
+    dsp.addScalar(o, 1.f, o, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(o[i], a[i] * -2.f + 1.f) << offset << ", " << i;
+    }
+  }
+}
+
 TEST(FBDSP, Multiply) {
   FBDSP dsp;
   const size_t numSamples = 11;
@@ -22,12 +170,14 @@ TEST(FBDSP, Multiply) {
     ASSERT_EQ(out[i], inA[i] * inB[i]) << " Idx " << i;
   }
 
+#ifndef TBE_STATIC_ISA
   // Repeat the test with non-vectorized implementation
   Internal::dspInit<float>(&dsp);
   dsp.multiply(inA, inB, out, numSamples);
   for (size_t i = 0; i < numSamples; ++i) {
     ASSERT_EQ(out[i], inA[i] * inB[i]) << " Idx " << i;
   }
+#endif
 }
 
 TEST(FBDSP, MultiplyScalar) {
@@ -42,10 +192,12 @@ TEST(FBDSP, MultiplyScalar) {
     ASSERT_EQ(out[i], in[i] * scalar) << " Idx " << i;
   }
 
+#ifndef TBE_STATIC_ISA
   Internal::dspInit<float>(&dsp);
   for (size_t i = 0; i < numSamples; ++i) {
     ASSERT_EQ(out[i], in[i] * scalar) << " Idx " << i;
   }
+#endif
 }
 
 TEST(FBDSP, Add) {
@@ -60,11 +212,13 @@ TEST(FBDSP, Add) {
     ASSERT_EQ(out[i], inA[i] + inB[i]) << " Idx " << i;
   }
 
+#ifndef TBE_STATIC_ISA
   Internal::dspInit<float>(&dsp);
   dsp.add(inA, inB, out, numSamples);
   for (size_t i = 0; i < numSamples; ++i) {
     ASSERT_EQ(out[i], inA[i] + inB[i]) << " Idx " << i;
   }
+#endif
 }
 
 TEST(FBDSP, AddScalar) {
@@ -79,11 +233,13 @@ TEST(FBDSP, AddScalar) {
     ASSERT_EQ(out[i], in[i] + scalar) << " Idx " << i;
   }
 
+#ifndef TBE_STATIC_ISA
   Internal::dspInit<float>(&dsp);
   dsp.addScalar(in, scalar, out, numSamples);
   for (size_t i = 0; i < numSamples; ++i) {
     ASSERT_EQ(out[i], in[i] + scalar) << " Idx " << i;
   }
+#endif
 }
 
 TEST(FBDSP, MultiplyInputAndAdd) {
@@ -99,11 +255,378 @@ TEST(FBDSP, MultiplyInputAndAdd) {
     ASSERT_EQ(output[i], (in[i] * scalar) + bufferToAdd[i]) << " Idx " << i;
   }
 
+#ifndef TBE_STATIC_ISA
   Internal::dspInit<float>(&dsp);
   dsp.multiplyInputAndAdd(in, scalar, bufferToAdd, output, numSamples);
   for (size_t i = 0; i < numSamples; ++i) {
     ASSERT_EQ(output[i], (in[i] * scalar) + bufferToAdd[i]) << " Idx " << i;
   }
+#endif
+}
+
+TEST(FBDSP, MultiplyRamp) {
+  FBDSP dsp;
+  const size_t numSamples = 37;
+  float in[numSamples];
+  float bufferToAdd[numSamples];
+  float out[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    in[i] = 1.f + 0.5f * static_cast<float>(i);
+    bufferToAdd[i] = -0.25f * static_cast<float>(i);
+  }
+
+  auto linearGain = [&](float start, float end, size_t i) {
+    return start + (end - start) * static_cast<float>(i) / static_cast<float>(numSamples);
+  };
+  auto expGain = [&](float start, float end, size_t i) {
+    return start * std::pow(end / start, static_cast<float>(i) / static_cast<float>(numSamples));
+  };
+
+  auto run = [&]() {
+    const float start = 0.25f;
+    const float end = 2.f;
+
+    dsp.multiplyRamp(in, start, end, out, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_NEAR(out[i], in[i] * linearGain(start, end, i), 1e-4f) << " Idx " << i;
+    }
+
+    // Fading in from silence
+    dsp.multiplyRamp(in, 0.f, 1.f, out, numSamples);
+    ASSERT_EQ(out[0], 0.f);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_NEAR(out[i], in[i] * linearGain(0.f, 1.f, i), 1e-4f) << " Idx " << i;
+    }
+
+    dsp.multiplyRampExp(in, start, end, out, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_NEAR(out[i], in[i] * expGain(start, end, i), 1e-4f) << " Idx " << i;
+    }
+
+    dsp.multiplyRampAndAdd(in, start, end, bufferToAdd, out, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_NEAR(out[i], in[i] * linearGain(start, end, i) + bufferToAdd[i], 1e-4f)
+          << " Idx " << i;
+    }
+
+    dsp.multiplyRampExpAndAdd(in, start, end, bufferToAdd, out, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_NEAR(out[i], in[i] * expGain(start, end, i) + bufferToAdd[i], 1e-4f) << " Idx " << i;
+    }
+
+    // A constant ramp is the same as multiplyScalar
+    float constant[numSamples];
+    dsp.multiplyScalar(in, 0.7f, constant, numSamples);
+    dsp.multiplyRamp(in, 0.7f, 0.7f, out, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_FLOAT_EQ(out[i], constant[i]) << " Idx " << i;
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+TEST(FBDSP, Reductions) {
+  FBDSP dsp;
+  // Long enough for the unrolled loop, the single register loop and a scalar tail
+  const size_t numSamples = 75;
+  float inA[numSamples];
+  float inB[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    inA[i] = std::sin(0.3f * static_cast<float>(i)) * static_cast<float>(i % 7);
+    inB[i] = 0.5f - 0.01f * static_cast<float>(i);
+  }
+  inA[41] = -9.5f; // the peak is negative
+
+  double expectedSum = 0.0, expectedSumOfSquares = 0.0, expectedDot = 0.0;
+  float expectedMin = inA[0], expectedMax = inA[0];
+  for (size_t i = 0; i < numSamples; ++i) {
+    expectedSum += inA[i];
+    expectedSumOfSquares += inA[i] * inA[i];
+    expectedDot += inA[i] * inB[i];
+    expectedMin = std::min(expectedMin, inA[i]);
+    expectedMax = std::max(expectedMax, inA[i]);
+  }
+
+  auto run = [&]() {
+    for (size_t len : {size_t(0), size_t(3), size_t(8), size_t(33), numSamples}) {
+      float peak = 0.f;
+      for (size_t i = 0; i < len; ++i) {
+        peak = std::max(peak, std::abs(inA[i]));
+      }
+      ASSERT_EQ(dsp.peak(inA, len), peak) << " Len " << len;
+    }
+
+    // A NaN anywhere, in the unrolled loop, a lane or the scalar tail, is the peak
+    for (size_t position : {size_t(0), size_t(5), size_t(17), size_t(40), numSamples - 1}) {
+      float withNaN[numSamples];
+      memcpy(withNaN, inA, sizeof(inA));
+      withNaN[position] = std::numeric_limits<float>::quiet_NaN();
+      ASSERT_TRUE(std::isnan(dsp.peak(withNaN, numSamples))) << " Position " << position;
+    }
+
+    ASSERT_NEAR(dsp.sum(inA, numSamples), expectedSum, 1e-3);
+    ASSERT_NEAR(dsp.sumOfSquares(inA, numSamples), expectedSumOfSquares, 1e-2);
+    ASSERT_NEAR(dsp.dotProduct(inA, inB, numSamples), expectedDot, 1e-3);
+
+    float minValue = 0.f, maxValue = 0.f;
+    dsp.minMax(inA, numSamples, &minValue, &maxValue);
+    ASSERT_EQ(minValue, expectedMin);
+    ASSERT_EQ(maxValue, expectedMax);
+    ASSERT_EQ(minValue, -9.5f);
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+TEST(FBDSP, ConvertInt16) {
+  FBDSP dsp;
+  const size_t numSamples = 21;
+  int16_t in[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    in[i] = static_cast<int16_t>(-32768 + static_cast<int32_t>(i) * 3277);
+  }
+  float asFloat[numSamples];
+  int16_t out[numSamples];
+
+  const float overRange[4] = {1.5f, -1.5f, 0.99999f, -1.f};
+  int16_t saturated[4];
+
+  auto run = [&]() {
+    dsp.convertInt16ToFloat(in, asFloat, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(asFloat[i], static_cast<float>(in[i]) / 32768.f) << " Idx " << i;
+    }
+
+    // Round trip is lossless without dither
+    dsp.convertFloatToInt16(asFloat, out, numSamples, nullptr);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(out[i], in[i]) << " Idx " << i;
+    }
+
+    dsp.convertFloatToInt16(overRange, saturated, 4, nullptr);
+    ASSERT_EQ(saturated[0], 32767);
+    ASSERT_EQ(saturated[1], -32768);
+    ASSERT_EQ(saturated[2], 32767);
+    ASSERT_EQ(saturated[3], -32768);
+
+    // Dither moves samples by less than one LSB either way
+    uint32_t ditherState = 1234;
+    dsp.convertFloatToInt16(asFloat, out, numSamples, &ditherState);
+    ASSERT_NE(ditherState, 1234u);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_LE(std::abs(static_cast<int32_t>(out[i]) - in[i]), 1) << " Idx " << i;
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+// Compares the vector kernels with the scalar ones, which are the same in the static mode
+#ifndef TBE_STATIC_ISA
+TEST(FBDSP, ConvertDitherIsDeterministic) {
+  FBDSP dsp;
+  const size_t numSamples = 1000;
+  float in[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    in[i] = 0.3f * std::sin(0.01f * static_cast<float>(i));
+  }
+  int16_t simdOut[numSamples];
+  int16_t scalarOut[numSamples];
+
+  uint32_t simdState = 42;
+  dsp.convertFloatToInt16(in, simdOut, numSamples, &simdState);
+  Internal::dspInit<float>(&dsp);
+  uint32_t scalarState = 42;
+  dsp.convertFloatToInt16(in, scalarOut, numSamples, &scalarState);
+
+  // The dither sequence doesn't depend on the vector width
+  ASSERT_EQ(simdState, scalarState);
+  double meanError = 0.0;
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(simdOut[i], scalarOut[i]) << " Idx " << i;
+    meanError += simdOut[i] - in[i] * 32768.0;
+  }
+  EXPECT_LT(std::abs(meanError / numSamples), 0.1);
+}
+#endif
+
+TEST(FBDSP, ConvertInt24AndInt32) {
+  FBDSP dsp;
+  const size_t numSamples = 150; // more than one internal chunk
+  float in[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    in[i] = -1.f + 2.f * static_cast<float>(i) / static_cast<float>(numSamples);
+  }
+  in[0] = 2.f;
+  in[1] = -2.f;
+
+  uint8_t packed[3 * numSamples];
+  int32_t wide[numSamples];
+  float out[numSamples];
+
+  auto run = [&]() {
+    dsp.convertFloatToInt24(in, packed, numSamples, nullptr);
+    // Saturated to full scale, little endian
+    ASSERT_EQ(packed[0], 0xFF);
+    ASSERT_EQ(packed[1], 0xFF);
+    ASSERT_EQ(packed[2], 0x7F);
+    ASSERT_EQ(packed[3], 0x00);
+    ASSERT_EQ(packed[4], 0x00);
+    ASSERT_EQ(packed[5], 0x80);
+
+    dsp.convertInt24ToFloat(packed, out, numSamples);
+    ASSERT_NEAR(out[0], 1.f, 1e-6f);
+    ASSERT_EQ(out[1], -1.f);
+    for (size_t i = 2; i < numSamples; ++i) {
+      ASSERT_NEAR(out[i], in[i], 1.f / 8388608.f) << " Idx " << i;
+    }
+
+    dsp.convertFloatToInt32(in, wide, numSamples);
+    ASSERT_EQ(wide[0], 2147483520);
+    ASSERT_EQ(wide[1], std::numeric_limits<int32_t>::min());
+    dsp.convertInt32ToFloat(wide, out, numSamples);
+    for (size_t i = 2; i < numSamples; ++i) {
+      ASSERT_EQ(out[i], in[i]) << " Idx " << i;
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+TEST(FBDSP, ConvertNaNIsSilent) {
+  FBDSP dsp;
+  // 19 and 20 are in the tail of the AVX kernels, 19 is in the body of the SSE and NEON ones
+  const size_t numSamples = 21;
+  const size_t kNaNPositions[] = {0, 7, 19, 20};
+  float in[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    in[i] = -0.5f;
+  }
+  for (size_t position : kNaNPositions) {
+    in[position] = std::numeric_limits<float>::quiet_NaN();
+  }
+  int16_t out16[numSamples];
+  uint8_t packed[3 * numSamples];
+  int32_t out32[numSamples];
+
+  auto run = [&]() {
+    uint32_t ditherState = 1234;
+    dsp.convertFloatToInt16(in, out16, numSamples, nullptr);
+    for (size_t position : kNaNPositions) {
+      ASSERT_EQ(out16[position], 0) << " Idx " << position;
+    }
+    ASSERT_EQ(out16[1], -16384);
+    dsp.convertFloatToInt16(in, out16, numSamples, &ditherState);
+    for (size_t position : kNaNPositions) {
+      ASSERT_EQ(out16[position], 0) << " Idx " << position;
+    }
+
+    dsp.convertFloatToInt24(in, packed, numSamples, nullptr);
+    for (size_t position : kNaNPositions) {
+      ASSERT_EQ(packed[3 * position], 0) << " Idx " << position;
+      ASSERT_EQ(packed[3 * position + 1], 0) << " Idx " << position;
+      ASSERT_EQ(packed[3 * position + 2], 0) << " Idx " << position;
+    }
+
+    dsp.convertFloatToInt32(in, out32, numSamples);
+    for (size_t position : kNaNPositions) {
+      ASSERT_EQ(out32[position], 0) << " Idx " << position;
+    }
+    ASSERT_EQ(out32[1], -1073741824);
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+TEST(FBDSP, Interleave) {
+  FBDSP dsp;
+  const size_t numFrames = 19;
+  const size_t maxChannels = 3;
+
+  float planar[maxChannels][numFrames];
+  float roundTrip[maxChannels][numFrames];
+  const float* inputs[maxChannels];
+  float* outputs[maxChannels];
+  for (size_t ch = 0; ch < maxChannels; ++ch) {
+    for (size_t n = 0; n < numFrames; ++n) {
+      planar[ch][n] = static_cast<float>(ch * 100 + n);
+    }
+    inputs[ch] = planar[ch];
+    outputs[ch] = roundTrip[ch];
+  }
+  float interleaved[maxChannels * numFrames];
+
+  auto run = [&]() {
+    for (size_t numChannels = 1; numChannels <= maxChannels; ++numChannels) {
+      dsp.interleave(inputs, numChannels, interleaved, numFrames);
+      for (size_t n = 0; n < numFrames; ++n) {
+        for (size_t ch = 0; ch < numChannels; ++ch) {
+          ASSERT_EQ(interleaved[n * numChannels + ch], planar[ch][n])
+              << " Channels " << numChannels << " Frame " << n;
+        }
+      }
+
+      memset(roundTrip, 0, sizeof(roundTrip));
+      dsp.deinterleave(interleaved, numChannels, outputs, numFrames);
+      for (size_t ch = 0; ch < numChannels; ++ch) {
+        for (size_t n = 0; n < numFrames; ++n) {
+          ASSERT_EQ(roundTrip[ch][n], planar[ch][n])
+              << " Channels " << numChannels << " Frame " << n;
+        }
+      }
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+TEST(FBDSP, MixAndClip) {
+  FBDSP dsp;
+  const size_t numSamples = 23;
+  float inA[numSamples], inB[numSamples], out[numSamples];
+  for (size_t i = 0; i < numSamples; ++i) {
+    inA[i] = static_cast<float>(i) - 11.f;
+    inB[i] = 0.25f * static_cast<float>(i);
+  }
+
+  auto run = [&]() {
+    dsp.mixAndClip(inA, 0.5f, inB, 0.2f, 1.f, out, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      const float expected = std::min(std::max((inA[i] * 0.5f + inB[i]) * 0.2f, -1.f), 1.f);
+      EXPECT_FLOAT_EQ(out[i], expected) << i;
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
 }
 
 TEST(FBDSP, isBufferSilent) {
@@ -133,6 +656,262 @@ TEST(FBDSP, isBufferSilent) {
   const float in4[numSamples] = {
       -0.0, 0.0, -0.0, -0.0, -0.00001, 0.00001, 0.0, 0.0, -0.0, 0.0, -0.0};
   ASSERT_TRUE(dsp.isBufferSilent(in4, numSamples));
+
+  // Only the last sample, after several search blocks, is above the threshold
+  const size_t numLongSamples = 301;
+  float in5[numLongSamples] = {0.f};
+  ASSERT_TRUE(dsp.isBufferSilent(in5, numLongSamples));
+  in5[numLongSamples - 1] = 0.001f;
+  ASSERT_FALSE(dsp.isBufferSilent(in5, numLongSamples));
+}
+
+TEST(Denormals, ScopedDenormalGuard) {
+  if (!ScopedDenormalGuard::isSupported()) {
+    ScopedDenormalGuard guard;
+    EXPECT_FALSE(guard.isActive());
+    return;
+  }
+
+  // volatile keeps the compiler from folding the products at compile time
+  volatile float tiny = 1e-30f;
+  volatile float scale = 1e-10f;
+  {
+    ScopedDenormalGuard guard;
+    EXPECT_TRUE(guard.isActive());
+    {
+      ScopedDenormalGuard nested;
+      EXPECT_EQ(tiny * scale, 0.f);
+    }
+    // The nested guard must not clear the flags of the outer one
+    EXPECT_EQ(tiny * scale, 0.f);
+  }
+  EXPECT_NE(tiny * scale, 0.f);
+
+  ScopedDenormalGuard disabled(false);
+  EXPECT_FALSE(disabled.isActive());
+  EXPECT_NE(tiny * scale, 0.f);
+}
+
+TEST(Denormals, flushDenormals) {
+  float buffer[7] = {1e-39f, -1e-40f, 0.f, 1.f, FLT_MIN, -2.f, -FLT_MIN};
+  flushDenormals(buffer, 7);
+  const float expected[7] = {0.f, 0.f, 0.f, 1.f, FLT_MIN, -2.f, -FLT_MIN};
+  for (size_t i = 0; i < 7; ++i) {
+    EXPECT_EQ(buffer[i], expected[i]) << i;
+  }
+}
+
+TEST(Denormals, FIRDenormalProtection) {
+  const size_t numTaps = 64;
+  const size_t numSamples = 67;
+  float ir[numTaps];
+  float input[numSamples];
+  float output[numSamples];
+  for (size_t i = 0; i < numTaps; ++i) {
+    ir[i] = 0.5f;
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    input[i] = 1e-39f;
+  }
+
+  FIR fir(ir, numTaps);
+  FIR firLinear(ir, numTaps);
+  EXPECT_FALSE(fir.getDenormalProtection());
+  fir.setDenormalProtection(true);
+  firLinear.setDenormalProtection(true);
+
+  // Either the inputs are treated as zero or the denormal results are flushed
+  fir.process(input, output, numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(output[i], 0.f) << i;
+  }
+  firLinear.processLinear(input, output, numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(output[i], 0.f) << i;
+  }
+}
+
+TEST(FBDSP, MatrixMix) {
+  FBDSP dsp;
+  const size_t numSamples = 13;
+  const size_t numInputs = 3;
+  const size_t numOutputs = 6; // one full pass of outputs plus a remainder
+
+  float inData[numInputs][numSamples];
+  for (size_t i = 0; i < numInputs; ++i) {
+    for (size_t n = 0; n < numSamples; ++n) {
+      inData[i][n] = static_cast<float>(n) - static_cast<float>(i) * 0.5f;
+    }
+  }
+  const float* inputs[numInputs] = {inData[0], inData[1], inData[2]};
+
+  float gains[numOutputs * numInputs];
+  for (size_t g = 0; g < numOutputs * numInputs; ++g) {
+    gains[g] = 0.25f * static_cast<float>(g) - 1.f;
+  }
+
+  float outData[numOutputs][numSamples] = {{0.f}};
+  float* outputs[numOutputs];
+  for (size_t j = 0; j < numOutputs; ++j) {
+    outputs[j] = outData[j];
+  }
+
+  auto check = [&]() {
+    for (size_t j = 0; j < numOutputs; ++j) {
+      for (size_t n = 0; n < numSamples; ++n) {
+        float expected = 0.f;
+        for (size_t i = 0; i < numInputs; ++i) {
+          expected += gains[j * numInputs + i] * inData[i][n];
+        }
+        ASSERT_FLOAT_EQ(outData[j][n], expected) << " Out " << j << " Idx " << n;
+      }
+    }
+  };
+
+  dsp.matrixMix(inputs, numInputs, gains, outputs, numOutputs, numSamples);
+  check();
+
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  memset(outData, 0, sizeof(outData));
+  dsp.matrixMix(inputs, numInputs, gains, outputs, numOutputs, numSamples);
+  check();
+#endif
+}
+
+TEST(FBDSP, MatrixMixAdd) {
+  FBDSP dsp;
+  const size_t numSamples = 19;
+  const size_t numInputs = 2;
+  const size_t numOutputs = 5;
+
+  float inData[numInputs][numSamples];
+  for (size_t i = 0; i < numInputs; ++i) {
+    for (size_t n = 0; n < numSamples; ++n) {
+      inData[i][n] = static_cast<float>(n * (i + 1));
+    }
+  }
+  const float* inputs[numInputs] = {inData[0], inData[1]};
+  const float gains[numOutputs * numInputs] = {
+      1.f, 0.f, 0.f, 1.f, 0.5f, 0.5f, -1.f, 2.f, 3.f, -3.f};
+
+  float outData[numOutputs][numSamples];
+  float* outputs[numOutputs];
+  for (size_t j = 0; j < numOutputs; ++j) {
+    outputs[j] = outData[j];
+  }
+
+  auto run = [&]() {
+    for (size_t j = 0; j < numOutputs; ++j) {
+      for (size_t n = 0; n < numSamples; ++n) {
+        outData[j][n] = 1.f;
+      }
+    }
+    dsp.matrixMixAdd(inputs, numInputs, gains, outputs, numOutputs, numSamples);
+    for (size_t j = 0; j < numOutputs; ++j) {
+      for (size_t n = 0; n < numSamples; ++n) {
+        const float expected =
+            1.f + gains[j * numInputs] * inData[0][n] + gains[j * numInputs + 1] * inData[1][n];
+        ASSERT_FLOAT_EQ(outData[j][n], expected) << " Out " << j << " Idx " << n;
+      }
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+TEST(FBDSP, MatrixMixBlockDiagonal) {
+  FBDSP dsp;
+  const size_t numSamples = 11;
+  const size_t numChannels = 4;
+  const size_t blockSizes[2] = {1, 3};
+
+  // A 1OA rotation of 90 degrees about the vertical axis: W untouched, X -> Y and Y -> -X
+  const float gains[1 + 9] = {1.f, 0.f, 0.f, 1.f, 0.f, 1.f, 0.f, -1.f, 0.f, 0.f};
+
+  float inData[numChannels][numSamples];
+  float outData[numChannels][numSamples];
+  const float* inputs[numChannels];
+  float* outputs[numChannels];
+  for (size_t ch = 0; ch < numChannels; ++ch) {
+    for (size_t n = 0; n < numSamples; ++n) {
+      inData[ch][n] = static_cast<float>(ch + 1) + 0.1f * static_cast<float>(n);
+    }
+    inputs[ch] = inData[ch];
+    outputs[ch] = outData[ch];
+  }
+
+  auto run = [&]() {
+    memset(outData, 0, sizeof(outData));
+    dsp.matrixMixBlockDiagonal(inputs, gains, blockSizes, 2, outputs, numSamples);
+    for (size_t n = 0; n < numSamples; ++n) {
+      ASSERT_FLOAT_EQ(outData[0][n], inData[0][n]) << " Idx " << n;
+      ASSERT_FLOAT_EQ(outData[1][n], inData[3][n]) << " Idx " << n;
+      ASSERT_FLOAT_EQ(outData[2][n], inData[2][n]) << " Idx " << n;
+      ASSERT_FLOAT_EQ(outData[3][n], -inData[1][n]) << " Idx " << n;
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
+}
+
+TEST(FBDSP, MatrixMixInterpolated) {
+  FBDSP dsp;
+  const size_t numSamples = 23;
+  const size_t numInputs = 3;
+  const size_t numOutputs = 5;
+
+  float inData[numInputs][numSamples];
+  for (size_t i = 0; i < numInputs; ++i) {
+    for (size_t n = 0; n < numSamples; ++n) {
+      inData[i][n] = 1.f - 0.05f * static_cast<float>(n) + static_cast<float>(i);
+    }
+  }
+  const float* inputs[numInputs] = {inData[0], inData[1], inData[2]};
+
+  float gainsStart[numOutputs * numInputs];
+  float gainsEnd[numOutputs * numInputs];
+  for (size_t g = 0; g < numOutputs * numInputs; ++g) {
+    gainsStart[g] = 0.1f * static_cast<float>(g);
+    gainsEnd[g] = 1.f - 0.2f * static_cast<float>(g);
+  }
+
+  float outData[numOutputs][numSamples];
+  float* outputs[numOutputs];
+  for (size_t j = 0; j < numOutputs; ++j) {
+    outputs[j] = outData[j];
+  }
+
+  auto run = [&]() {
+    memset(outData, 0, sizeof(outData));
+    dsp.matrixMixInterpolated(
+        inputs, numInputs, gainsStart, gainsEnd, outputs, numOutputs, numSamples);
+    for (size_t j = 0; j < numOutputs; ++j) {
+      for (size_t n = 0; n < numSamples; ++n) {
+        const float pos = static_cast<float>(n) / static_cast<float>(numSamples);
+        float expected = 0.f;
+        for (size_t i = 0; i < numInputs; ++i) {
+          const size_t g = j * numInputs + i;
+          expected += (gainsStart[g] + (gainsEnd[g] - gainsStart[g]) * pos) * inData[i][n];
+        }
+        ASSERT_NEAR(outData[j][n], expected, 1e-5f) << " Out " << j << " Idx " << n;
+      }
+    }
+  };
+
+  run();
+#ifndef TBE_STATIC_ISA
+  Internal::dspInit<float>(&dsp);
+  run();
+#endif
 }
 
 // For testing sake this code is from the ICST library
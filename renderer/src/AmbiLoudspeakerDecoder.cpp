@@ -0,0 +1,239 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "AmbiLoudspeakerDecoder.hh"
+
+#include <cmath>
+
+namespace TBE {
+namespace {
+const double kDegToRad = M_PI / 180.0;
+
+// Regularisation added to the diagonal before inverting, keeps near-degenerate layouts stable
+const double kRegularisation = 1e-9;
+
+//
+// In place Gauss-Jordan inversion with partial pivoting of a row-major size x size matrix.
+// Returns false if the matrix is singular.
+//
+bool invert(std::vector<double>& m, size_t size) {
+  std::vector<double> inv(size * size, 0.0);
+  for (size_t i = 0; i < size; ++i) {
+    inv[i * size + i] = 1.0;
+  }
+
+  for (size_t col = 0; col < size; ++col) {
+    size_t pivot = col;
+    for (size_t row = col + 1; row < size; ++row) {
+      if (std::abs(m[row * size + col]) > std::abs(m[pivot * size + col])) {
+        pivot = row;
+      }
+    }
+
+    if (std::abs(m[pivot * size + col]) < 1e-12) {
+      return false;
+    }
+
+    if (pivot != col) {
+      for (size_t k = 0; k < size; ++k) {
+        std::swap(m[pivot * size + k], m[col * size + k]);
+        std::swap(inv[pivot * size + k], inv[col * size + k]);
+      }
+    }
+
+    const double scale = 1.0 / m[col * size + col];
+    for (size_t k = 0; k < size; ++k) {
+      m[col * size + k] *= scale;
+      inv[col * size + k] *= scale;
+    }
+
+    for (size_t row = 0; row < size; ++row) {
+      const double factor = m[row * size + col];
+      if (row == col || factor == 0.0) {
+        continue;
+      }
+      for (size_t k = 0; k < size; ++k) {
+        m[row * size + k] -= factor * m[col * size + k];
+        inv[row * size + k] -= factor * inv[col * size + k];
+      }
+    }
+  }
+
+  m.swap(inv);
+  return true;
+}
+} // namespace
+
+AmbiLoudspeakerDecoder::AmbiLoudspeakerDecoder(
+    AmbisonicOrder order,
+    const LoudspeakerPosition* speakers,
+    size_t numSpeakers)
+    : ambisonicOrder_(static_cast<size_t>(order)),
+      numHarmonics_((ambisonicOrder_ + 1) * (ambisonicOrder_ + 1)),
+      numSpeakers_(numSpeakers),
+      decodingMatrix_(numSpeakers * numHarmonics_, 0.f),
+      inputChannels_(numHarmonics_),
+      outputChannels_(numSpeakers) {
+  assert(order != AmbisonicOrder::INVALID);
+  assert(speakers);
+  assert(numSpeakers > 0);
+
+  const size_t H = numHarmonics_;
+  const size_t S = numSpeakers_;
+
+  // Spherical harmonic matrix of the layout, row-major H x S (one column per speaker)
+  std::vector<double> Y(H * S);
+  std::vector<double> column(H);
+  for (size_t s = 0; s < S; ++s) {
+    computeSN3D(ambisonicOrder_, speakers[s].azimuth, speakers[s].elevation, column.data());
+    for (size_t h = 0; h < H; ++h) {
+      Y[h * S + s] = column[h];
+    }
+  }
+
+  //
+  // Mode matching: the decoder is the pseudo-inverse of Y so that re-encoding the speaker feeds
+  // reproduces the input field. With at least as many speakers as harmonics this is
+  // Y^T (Y Y^T)^-1, otherwise the least squares solution (Y^T Y)^-1 Y^T.
+  //
+  if (S >= H) {
+    std::vector<double> gram(H * H, 0.0);
+    for (size_t a = 0; a < H; ++a) {
+      for (size_t b = 0; b < H; ++b) {
+        double sum = 0.0;
+        for (size_t s = 0; s < S; ++s) {
+          sum += Y[a * S + s] * Y[b * S + s];
+        }
+        gram[a * H + b] = sum + (a == b ? kRegularisation : 0.0);
+      }
+    }
+    const bool inverted = invert(gram, H);
+    assert(inverted);
+    (void)inverted;
+
+    for (size_t s = 0; s < S; ++s) {
+      for (size_t h = 0; h < H; ++h) {
+        double sum = 0.0;
+        for (size_t k = 0; k < H; ++k) {
+          sum += Y[k * S + s] * gram[k * H + h];
+        }
+        decodingMatrix_[s * H + h] = static_cast<float>(sum);
+      }
+    }
+  } else {
+    std::vector<double> gram(S * S, 0.0);
+    for (size_t a = 0; a < S; ++a) {
+      for (size_t b = 0; b < S; ++b) {
+        double sum = 0.0;
+        for (size_t h = 0; h < H; ++h) {
+          sum += Y[h * S + a] * Y[h * S + b];
+        }
+        gram[a * S + b] = sum + (a == b ? kRegularisation : 0.0);
+      }
+    }
+    const bool inverted = invert(gram, S);
+    assert(inverted);
+    (void)inverted;
+
+    for (size_t s = 0; s < S; ++s) {
+      for (size_t h = 0; h < H; ++h) {
+        double sum = 0.0;
+        for (size_t k = 0; k < S; ++k) {
+          sum += gram[s * S + k] * Y[h * S + k];
+        }
+        decodingMatrix_[s * H + h] = static_cast<float>(sum);
+      }
+    }
+  }
+}
+
+void AmbiLoudspeakerDecoder::computeSN3D(
+    size_t order,
+    float azimuth,
+    float elevation,
+    double* coefficients) {
+  assert(coefficients);
+  const double az = azimuth * kDegToRad;
+  const double x = std::sin(elevation * kDegToRad);
+  const double cosEl = std::cos(elevation * kDegToRad);
+
+  for (size_t m = 0; m <= order; ++m) {
+    //
+    // Associated Legendre functions without the Condon-Shortley phase, computed with the
+    // standard recursion in l for a fixed m
+    //
+    double pmm = 1.0;
+    for (size_t k = 1; k <= m; ++k) {
+      pmm *= (2.0 * k - 1.0) * cosEl;
+    }
+
+    double pPrev = 0.0;
+    double p = pmm;
+    for (size_t l = m; l <= order; ++l) {
+      if (l == m + 1) {
+        pPrev = p;
+        p = x * (2.0 * m + 1.0) * pmm;
+      } else if (l > m + 1) {
+        const double next = ((2.0 * l - 1.0) * x * p - (l + m - 1.0) * pPrev) / (l - m);
+        pPrev = p;
+        p = next;
+      }
+
+      // SN3D normalisation: sqrt((2 - delta_m0) * (l - m)! / (l + m)!)
+      double ratio = 1.0;
+      for (size_t k = l - m + 1; k <= l + m; ++k) {
+        ratio /= static_cast<double>(k);
+      }
+      const double norm = std::sqrt((m == 0 ? 1.0 : 2.0) * ratio);
+
+      const size_t acn = l * l + l;
+      coefficients[acn + m] = norm * p * std::cos(m * az);
+      if (m > 0) {
+        coefficients[acn - m] = norm * p * std::sin(m * az);
+      }
+    }
+  }
+}
+
+void AmbiLoudspeakerDecoder::process(
+    const float** ambisonicIn,
+    float** speakerOut,
+    int bufferLength) {
+  assert(ambisonicIn);
+  assert(speakerOut);
+  assert(bufferLength >= 0);
+
+  dsp_->matrixMix(
+      ambisonicIn,
+      numHarmonics_,
+      decodingMatrix_.data(),
+      speakerOut,
+      numSpeakers_,
+      static_cast<size_t>(bufferLength));
+}
+
+void AmbiLoudspeakerDecoder::process(
+    const ConstAudioBufferView& ambisonicIn,
+    const AudioBufferView& speakerOut) {
+  assert(ambisonicIn.getNumOfChannels() >= static_cast<int32_t>(numHarmonics_));
+  assert(speakerOut.getNumOfChannels() == static_cast<int32_t>(numSpeakers_));
+  assert(ambisonicIn.getSamplesPerChannel() >= speakerOut.getSamplesPerChannel());
+
+  // The views may start part way into their channels, so the kernel gets tables of their own
+  ambisonicIn.channels(0, static_cast<int32_t>(numHarmonics_))
+      .getChannelPointers(inputChannels_.data());
+  speakerOut.getChannelPointers(outputChannels_.data());
+
+  dsp_->matrixMix(
+      inputChannels_.data(),
+      numHarmonics_,
+      decodingMatrix_.data(),
+      outputChannels_.data(),
+      numSpeakers_,
+      static_cast<size_t>(speakerOut.getSamplesPerChannel()));
+}
+} // namespace TBE
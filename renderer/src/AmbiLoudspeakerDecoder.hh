@@ -0,0 +1,84 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "../../dsp/src/AudioBufferView.hh"
+#include "../../dsp/src/DSP.hh"
+#include "AmbiDefinitions.hh"
+
+#include <memory>
+#include <vector>
+
+namespace TBE {
+/// Position of a loudspeaker relative to the listener, in degrees. Azimuth is anti-clockwise from
+/// the front (90 is hard left) and elevation is positive upwards, as in the ambiX specification.
+struct LoudspeakerPosition {
+  float azimuth{0.f};
+  float elevation{0.f};
+};
+
+class AmbiLoudspeakerDecoder {
+ public:
+  /// A class to decode an Ambisonic field to a loudspeaker array. Input Ambisonics is assumed to be
+  /// in ACN channel order and SN3D normalisation (as proposed by the ambiX specification). The
+  /// decoding matrix is computed once with mode matching (the pseudo-inverse of the spherical
+  /// harmonic matrix of the layout) and is then applied with FBDSP::matrixMix, so no per-speaker
+  /// convolution takes place.
+  /// \param order The Ambisonic order of the input
+  /// \param speakers Positions of the loudspeakers, output channel n is fed to speakers[n]
+  /// \param numSpeakers Number of loudspeakers
+  AmbiLoudspeakerDecoder(
+      AmbisonicOrder order,
+      const LoudspeakerPosition* speakers,
+      size_t numSpeakers);
+
+  /// Decode the input Ambisonic audio to the loudspeaker feeds
+  /// \param ambisonicIn The Ambisonic audio input as an un-interleaved signal. ambisonicIn[0][0] =
+  /// harmonic 0, ambisonicIn[1][0] = harmonic 1, etc
+  /// \param speakerOut The loudspeaker feeds as an un-interleaved signal, one channel per speaker
+  /// \param bufferLength The number of samples in a mono buffer
+  void process(const float** ambisonicIn, float** speakerOut, int bufferLength);
+
+  /// Decode as above on views, e.g. a block of a longer buffer. The number of samples processed is
+  /// the length of speakerOut. Not thread safe: the channel tables of the views are built in
+  /// buffers of the decoder.
+  /// \param ambisonicIn The Ambisonic channels, at least as long as speakerOut
+  /// \param speakerOut One channel per speaker
+  void process(const ConstAudioBufferView& ambisonicIn, const AudioBufferView& speakerOut);
+
+  /// \return The row-major decoding matrix of getNumSpeakers() rows and getNumHarmonics() columns
+  const float* getDecodingMatrix() const {
+    return decodingMatrix_.data();
+  }
+
+  size_t getNumSpeakers() const {
+    return numSpeakers_;
+  }
+
+  size_t getNumHarmonics() const {
+    return numHarmonics_;
+  }
+
+  /// Evaluate the real SN3D spherical harmonics in ACN order for a direction
+  /// \param order The Ambisonic order
+  /// \param azimuth Azimuth in degrees
+  /// \param elevation Elevation in degrees
+  /// \param coefficients Output array of (order + 1)^2 coefficients
+  static void computeSN3D(size_t order, float azimuth, float elevation, double* coefficients);
+
+ private:
+  size_t ambisonicOrder_{0};
+  size_t numHarmonics_{0};
+  size_t numSpeakers_{0};
+
+  const FBDSP* dsp_{&FBDSP::shared()};
+  std::vector<float> decodingMatrix_;
+  std::vector<const float*> inputChannels_;
+  std::vector<float*> outputChannels_;
+};
+} // namespace TBE
@@ -6,76 +6,261 @@
  */
 
 #include "AmbiSphericalConvolution.hh"
+#include "../../dsp/src/Denormals.hh"
+
+#include <new>
+
 namespace TBE {
 AmbiSphericalConvolution::AmbiSphericalConvolution(
     size_t maxBufferSize,
     AmbisonicIRContainer ambisonicIR)
-    : maxBufferSize_(maxBufferSize), irs_(ambisonicIR), ambisonicOrder_(static_cast<int>(irs_.ambisonicOrder)) {
+    : irs_(ambisonicIR),
+      ambisonicOrder_(static_cast<int>(irs_.ambisonicOrder)),
+      maxBufferSize_(maxBufferSize) {
+  ownArena_ = std::unique_ptr<Arena>(new Arena(arenaSize(maxBufferSize, ambisonicIR)));
+  init(*ownArena_);
+}
+
+AmbiSphericalConvolution::AmbiSphericalConvolution(
+    size_t maxBufferSize,
+    AmbisonicIRContainer ambisonicIR,
+    Arena& arena)
+    : irs_(ambisonicIR),
+      ambisonicOrder_(static_cast<int>(irs_.ambisonicOrder)),
+      maxBufferSize_(maxBufferSize) {
+  init(arena);
+}
+
+AmbiSphericalConvolution::~AmbiSphericalConvolution() {
+  for (int hm = 0; hm < irs_.numHarmonics; hm++) {
+    ambiFir_[hm].~FIR();
+  }
+}
+
+size_t AmbiSphericalConvolution::arenaSize(
+    size_t maxBufferSize,
+    const AmbisonicIRContainer& ambisonicIR) {
+  size_t size = 2 * Arena::sizeOf<float>(maxBufferSize);
+  size += Arena::sizeOf<int>(ambisonicIR.numHarmonics);
+  size += Arena::sizeOf<FIR>(ambisonicIR.numHarmonics);
+  for (int hm = 0; hm < ambisonicIR.numHarmonics; hm++) {
+    size += FIR::sharedIRArenaSize(ambisonicIR.numTapsVec[hm]);
+  }
+  return size;
+}
+
+MemoryFootprint AmbiSphericalConvolution::memoryFootprint() const {
+  MemoryFootprint footprint;
+  for (int hm = 0; hm < irs_.numHarmonics; hm++) {
+    footprint += ambiFir_[hm].memoryFootprint();
+  }
+  // The FIR objects are counted by the filters, their padding in the arena is not
+  footprint.state.privateBytes +=
+      Arena::sizeOf<FIR>(irs_.numHarmonics) - irs_.numHarmonics * sizeof(FIR);
+  footprint.state.privateBytes += Arena::sizeOf<int>(irs_.numHarmonics);
+  footprint.state.privateBytes += sizeof(AmbiSphericalConvolution);
+  if (ownArena_) {
+    footprint.state.privateBytes += sizeof(Arena);
+  }
+  footprint.scratch.privateBytes += 2 * Arena::sizeOf<float>(maxBufferSize_);
+  return footprint;
+}
+
+void AmbiSphericalConvolution::init(Arena& arena) {
   // check for standard Ambisonic harmonic input count. More exotic mixed orders may be included at
   // a later time.
   assert((ambisonicOrder_ + 1) * (ambisonicOrder_ + 1) == irs_.numHarmonics);
-  assert(maxBufferSize > 0);
+  assert(maxBufferSize_ > 0);
   assert(irs_.ir);
   assert(irs_.ir[0]);
 
-  tmpBuf_ = std::unique_ptr<float[]>(new float[maxBufferSize]);
-  oddHmBuf_ = std::unique_ptr<float[]>(new float[maxBufferSize]);
-  silenceCounts_ = std::unique_ptr<int[]>(new int[irs_.numHarmonics]);
+  // The scratch buffers come first: they are touched by every harmonic
+  tmpBuf_ = arena.allocate<float>(maxBufferSize_);
+  oddHmBuf_ = arena.allocate<float>(maxBufferSize_);
+  silenceCounts_ = arena.allocate<int>(irs_.numHarmonics);
+  ambiFir_ = arena.allocate<FIR>(irs_.numHarmonics);
+  assert(tmpBuf_ && oddHmBuf_ && silenceCounts_ && ambiFir_);
 
-  int max_num_taps = 0;
-
-  if (irs_.numTapsVec) {
-    for (int hm = 0; hm < irs_.numHarmonics; hm++) {
-      const int num_taps = irs_.numTapsVec[hm];
-      max_num_taps = (num_taps > max_num_taps) ? num_taps : max_num_taps;
-    }
+  // initialise FIR filters, each followed by its delay line. The taps are shared by every
+  // renderer on the same IRs:
+  for (int hm = 0; hm < irs_.numHarmonics; hm++) {
+    const size_t numTaps = irs_.numTapsVec[hm];
+    new (&ambiFir_[hm]) FIR(SharedIR::get(irs_.ir[hm], numTaps, numTaps), arena);
+    ambiFir_[hm].setDenormalProtection(denormalProtection_);
+    silenceCounts_[hm] = 0;
   }
+}
 
-  // initialise FIR filters:
+void AmbiSphericalConvolution::setDenormalProtection(bool enabled) {
+  denormalProtection_ = enabled;
   for (int hm = 0; hm < irs_.numHarmonics; hm++) {
-    ambiFir_.emplace_back(irs_.ir[hm], ambisonicIR.numTapsVec[hm]);
-    silenceCounts_.get()[hm] = 0;
+    ambiFir_[hm].setDenormalProtection(enabled);
   }
 }
 
+void AmbiSphericalConvolution::setProfilingEnabled(bool enabled) {
+#ifndef TBE_DISABLE_PROFILING
+  profiler_.setEnabled(enabled);
+#else
+  (void)enabled;
+#endif
+}
+
+bool AmbiSphericalConvolution::getProfilingEnabled() const {
+#ifndef TBE_DISABLE_PROFILING
+  return profiler_.isEnabled();
+#else
+  return false;
+#endif
+}
+
+ConvolutionStats AmbiSphericalConvolution::getStats() const {
+#ifndef TBE_DISABLE_PROFILING
+  return profiler_.getStats();
+#else
+  ConvolutionStats stats;
+  memset(&stats, 0, sizeof(stats));
+  return stats;
+#endif
+}
+
+void AmbiSphericalConvolution::resetStats() {
+#ifndef TBE_DISABLE_PROFILING
+  profiler_.reset();
+#endif
+}
+
+void AmbiSphericalConvolution::setDeadlineMonitoring(float sampleRate) {
+  deadlineMonitor_.setSampleRate(sampleRate);
+}
+
 void AmbiSphericalConvolution::process(
     const float** ambisonicIn,
     float** binauralOut,
     int bufferLength) {
   assert(binauralOut);
   assert(ambisonicIn);
+  processImpl(
+      ConstAudioBufferView(ambisonicIn, irs_.numHarmonics, bufferLength),
+      AudioBufferView(binauralOut, 2, bufferLength),
+      ConstAudioBufferView(),
+      0.f);
+}
+
+void AmbiSphericalConvolution::process(
+    const float** ambisonicIn,
+    float** binauralOut,
+    int bufferLength,
+    const float** headLockedIn,
+    float headLockedGain) {
+  assert(binauralOut);
+  assert(ambisonicIn);
+  processImpl(
+      ConstAudioBufferView(ambisonicIn, irs_.numHarmonics, bufferLength),
+      AudioBufferView(binauralOut, 2, bufferLength),
+      headLockedIn ? ConstAudioBufferView(headLockedIn, 2, bufferLength) : ConstAudioBufferView(),
+      headLockedGain);
+}
+
+void AmbiSphericalConvolution::process(
+    const ConstAudioBufferView& ambisonicIn,
+    const AudioBufferView& binauralOut) {
+  processImpl(ambisonicIn, binauralOut, ConstAudioBufferView(), 0.f);
+}
+
+void AmbiSphericalConvolution::process(
+    const ConstAudioBufferView& ambisonicIn,
+    const AudioBufferView& binauralOut,
+    const ConstAudioBufferView& headLockedIn,
+    float headLockedGain) {
+  assert(headLockedIn.getNumOfChannels() == 2);
+  processImpl(ambisonicIn, binauralOut, headLockedIn, headLockedGain);
+}
+
+void AmbiSphericalConvolution::processImpl(
+    const ConstAudioBufferView& ambisonicIn,
+    const AudioBufferView& binauralOut,
+    const ConstAudioBufferView& headLockedIn,
+    float headLockedGain) {
+  const int bufferLength = binauralOut.getSamplesPerChannel();
+  assert(binauralOut.getNumOfChannels() == 2);
+  assert(ambisonicIn.getNumOfChannels() >= irs_.numHarmonics);
+  assert(ambisonicIn.getSamplesPerChannel() >= bufferLength);
   assert(bufferLength <= maxBufferSize_);
 
-  memset(binauralOut[0], 0, bufferLength * sizeof(float));
-  memset(oddHmBuf_.get(), 0, bufferLength * sizeof(float));
+  float* const left = binauralOut.getChannelData(0);
+  float* const right = binauralOut.getChannelData(1);
+
+  deadlineMonitor_.begin();
+
+  // Set once for the whole block, the guards of the FIRs then find the flags already set
+  ScopedDenormalGuard denormalGuard(denormalProtection_);
+
+#ifndef TBE_DISABLE_PROFILING
+  ConvolutionProfiler* const profiler = profiler_.isEnabled() ? &profiler_ : nullptr;
+#endif
+  TBE_PROFILE(profiler, beginBlock());
+
+  if (headLockedIn.getNumOfChannels() > 0) {
+    assert(headLockedIn.getNumOfChannels() == 2);
+    assert(headLockedIn.getSamplesPerChannel() >= bufferLength);
+    const float* headLocked[2] = {headLockedIn.getChannelData(0), headLockedIn.getChannelData(1)};
+    assert(headLocked[0] != left && headLocked[1] != left);
+    assert(headLocked[0] != right && headLocked[1] != right);
+
+    //
+    // The ears are built as left = even + odd and right = even - odd below. Seeding the even sum
+    // with the mid and the odd sum with the side of the head-locked stereo signal makes that same
+    // final pass produce left + L and right + R, instead of clearing both buffers here and mixing
+    // the stereo signal in with another pass over binauralOut.
+    //
+    const float halfGain = 0.5f * headLockedGain;
+    const float midSideGains[4] = {halfGain, halfGain, halfGain, -halfGain};
+    float* midSideOut[2] = {left, oddHmBuf_};
+    dsp_->matrixMix(headLocked, 2, midSideGains, midSideOut, 2, bufferLength);
+    TBE_PROFILE(profiler, lap(ConvolutionStage::HEAD_LOCKED_MIX));
+  } else {
+    memset(left, 0, bufferLength * sizeof(float));
+    memset(oddHmBuf_, 0, bufferLength * sizeof(float));
+    TBE_PROFILE(profiler, lap(ConvolutionStage::CLEAR));
+  }
 
   for (int l = 0; l <= ambisonicOrder_; l++) {
     for (int m = -l; m <= l; m++) {
       const int hm = l * l + l + m;
-      memset(tmpBuf_.get(), 0, bufferLength * sizeof(float));
+      const float* input = ambisonicIn.getChannelData(hm);
+      memset(tmpBuf_, 0, bufferLength * sizeof(float));
+      TBE_PROFILE(profiler, lap(ConvolutionStage::CLEAR, hm));
 
-      if (dsp_.isBufferSilent(ambisonicIn[hm], bufferLength)) {
-        silenceCounts_.get()[hm]++;
+      if (dsp_->isBufferSilent(input, bufferLength)) {
+        silenceCounts_[hm]++;
       } else {
-        silenceCounts_.get()[hm] = 0;
+        silenceCounts_[hm] = 0;
       }
+      TBE_PROFILE(profiler, lap(ConvolutionStage::SILENCE_CHECK, hm));
 
-      if (silenceCounts_.get()[hm] > 1) {
+      if (silenceCounts_[hm] > 1) {
+        TBE_PROFILE(profiler, skipped(hm));
         continue;
       }
 
-      ambiFir_[hm].process(ambisonicIn[hm], tmpBuf_.get(), bufferLength);
+      ambiFir_[hm].process(input, tmpBuf_, bufferLength);
+      TBE_PROFILE(profiler, lap(ConvolutionStage::FIR, hm));
 
       // flip harmonics with m < 0 for right ear output
       if (m < 0) {
-        dsp_.add(tmpBuf_.get(), oddHmBuf_.get(), oddHmBuf_.get(), bufferLength);
+        dsp_->add(tmpBuf_, oddHmBuf_, oddHmBuf_, bufferLength);
       } else {
-        dsp_.add(binauralOut[0], tmpBuf_.get(), binauralOut[0], bufferLength);
+        dsp_->add(left, tmpBuf_, left, bufferLength);
       }
+      TBE_PROFILE(profiler, lap(ConvolutionStage::ACCUMULATE, hm));
     }
   }
 
-  dsp_.multiplyInputAndAdd(oddHmBuf_.get(), -1.f, binauralOut[0], binauralOut[1], bufferLength);
-  dsp_.add(oddHmBuf_.get(), binauralOut[0], binauralOut[0], bufferLength);
+  dsp_->multiplyInputAndAdd(oddHmBuf_, -1.f, left, right, bufferLength);
+  dsp_->add(oddHmBuf_, left, left, bufferLength);
+  TBE_PROFILE(profiler, lap(ConvolutionStage::EAR_MIX));
+  TBE_PROFILE(profiler, endBlock(bufferLength));
+  deadlineMonitor_.end(bufferLength);
 }
 } // namespace TBE
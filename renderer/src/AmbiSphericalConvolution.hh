@@ -7,11 +7,14 @@
 
 #pragma once
 
+#include "../../dsp/src/AudioBufferView.hh"
+#include "../../dsp/src/DeadlineMonitor.hh"
 #include "../../dsp/src/DSP.hh"
+#include "../../dsp/src/MemoryFootprint.hh"
 #include "AmbiDefinitions.hh"
+#include "ConvolutionProfiler.hh"
 
 #include <memory>
-#include <vector>
 
 namespace TBE {
 class AmbiSphericalConvolution {
@@ -20,8 +23,32 @@ class AmbiSphericalConvolution {
   /// channel order, SN3D normalisation and SN3D normalisation (as proposed by the ambiX
   /// specification) \param maxBufferSize Maximum mono number of samples \param ambisonicIR Contains
   /// impulse response and Ambisonic order information
+  ///
+  /// The reversed taps are a SharedIR, shared read-only with every other renderer on the same
+  /// IRs; a renderer only owns its delay lines and scratch buffers. Constructing one locks the
+  /// store of shared IRs, do it off the audio thread.
   AmbiSphericalConvolution(size_t maxBufferSize, AmbisonicIRContainer ambisonicIR);
 
+  /// As above, but the filters, their delay lines and the scratch buffers are taken from an arena
+  /// the caller owns, for example one reused by the renderers of successive sessions. The arena
+  /// must outlive the renderer and have at least arenaSize() bytes free.
+  AmbiSphericalConvolution(size_t maxBufferSize, AmbisonicIRContainer ambisonicIR, Arena& arena);
+
+  ~AmbiSphericalConvolution();
+
+  AmbiSphericalConvolution(const AmbiSphericalConvolution&) = delete;
+  AmbiSphericalConvolution& operator=(const AmbiSphericalConvolution&) = delete;
+
+  /// \return The number of arena bytes used by a renderer with these parameters
+  static size_t arenaSize(size_t maxBufferSize, const AmbisonicIRContainer& ambisonicIR);
+
+  /// \return The bytes used by this renderer: the taps of its filters as shared coefficients, see
+  /// SharedIR, the delay lines, silence counters and the objects themselves as state, and the
+  /// block buffers as scratch. Everything in the arena counts as private, with its alignment
+  /// padding, whether the arena is owned or not; the IR arrays passed in are only read at
+  /// construction and not counted.
+  MemoryFootprint memoryFootprint() const;
+
   /// Process the input Ambisonic audio through the provided Ambisonic to binaural impulse responses
   /// \param ambisonicIn The Ambisonic audio input to be binaurally spatialised as an un-interleaved
   /// signal. ambisonicIn[0][0] = harmonic 0, ambisonicIn[1][0] = harmonic 1, etc \param binauralOut
@@ -30,15 +57,110 @@ class AmbiSphericalConvolution {
   /// \param bufferLength The number of samples in a mono buffer
   void process(const float** ambisonicIn, float** binauralOut, int bufferLength);
 
+  /// Process the input Ambisonic audio as above and mix a head-locked stereo signal into the
+  /// binaural output in the same pass. The stereo signal is not spatialised.
+  /// \param ambisonicIn The Ambisonic audio input to be binaurally spatialised as an un-interleaved
+  /// signal
+  /// \param binauralOut The rendered stereo binaural output as an un-interleaved signal
+  /// \param bufferLength The number of samples in a mono buffer
+  /// \param headLockedIn The head-locked stereo input as an un-interleaved signal.
+  /// headLockedIn[0][0] = left, headLockedIn[1][0] = right. May be null, but must not alias
+  /// binauralOut
+  /// \param headLockedGain Gain applied to the head-locked stereo input
+  void process(
+      const float** ambisonicIn,
+      float** binauralOut,
+      int bufferLength,
+      const float** headLockedIn,
+      float headLockedGain);
+
+  /// Process as above on views, e.g. a block of a longer buffer or the Ambisonic channels of a bed
+  /// with other channels, without copying. The number of samples processed is the length of
+  /// binauralOut.
+  /// \param ambisonicIn The Ambisonic channels, at least as long as binauralOut
+  /// \param binauralOut Two channels, left and right
+  void process(const ConstAudioBufferView& ambisonicIn, const AudioBufferView& binauralOut);
+
+  /// \param headLockedIn Two channels mixed into the output as above, at least as long as
+  /// binauralOut
+  /// \param headLockedGain Gain applied to the head-locked stereo input
+  void process(
+      const ConstAudioBufferView& ambisonicIn,
+      const AudioBufferView& binauralOut,
+      const ConstAudioBufferView& headLockedIn,
+      float headLockedGain);
+
+  /// Flush denormals to zero while processing, see ScopedDenormalGuard. Decaying IR tails and
+  /// silence after a sound otherwise leave denormals in the filter state, which show up as CPU
+  /// spikes on x86. Enabled by default.
+  /// \param enabled True to enable the protection
+  void setDenormalProtection(bool enabled);
+
+  bool getDenormalProtection() const {
+    return denormalProtection_;
+  }
+
+  /// Time each stage and harmonic of process() and count the harmonics skipped as silent, see
+  /// ConvolutionStats. Disabled by default; while disabled the instrumentation costs one branch
+  /// per stage. Building with TBE_DISABLE_PROFILING removes it entirely, and this does nothing.
+  /// Harmonics from kMaxProfiledHarmonics on only count towards the stage totals.
+  /// May be called from any thread.
+  /// \param enabled True to start collecting
+  void setProfilingEnabled(bool enabled);
+
+  bool getProfilingEnabled() const;
+
+  /// \return The counters as of the last block processed with profiling enabled, zeros if there
+  /// was none. Lock-free, may be called from any thread while process() runs.
+  ConvolutionStats getStats() const;
+
+  /// Zero the counters when the next block starts. May be called from any thread.
+  void resetStats();
+
+  /// Measure each process() call against the duration of the audio it renders, see
+  /// DeadlineMonitor, e.g. for telemetry to spot devices that are about to glitch. Disabled by
+  /// default. May be called from any thread.
+  /// \param sampleRate The sample rate of the rendered audio, 0 to disable
+  void setDeadlineMonitoring(float sampleRate);
+
+  /// \return The load histogram, worst case and overruns of the calls since monitoring was
+  /// enabled or reset. Lock-free, may be called from any thread while process() runs.
+  DeadlineStats getDeadlineStats() const {
+    return deadlineMonitor_.getStats();
+  }
+
+  /// Zero the deadline counters when the next call starts. May be called from any thread.
+  void resetDeadlineStats() {
+    deadlineMonitor_.reset();
+  }
+
  private:
   AmbisonicIRContainer irs_;
   size_t ambisonicOrder_{0};
   size_t maxBufferSize_{0};
+  bool denormalProtection_{true};
+
+  const FBDSP* dsp_{&FBDSP::shared()};
+
+  // All of the state below lives in one arena block, either ownArena_ or the caller's arena
+  std::unique_ptr<Arena> ownArena_;
+  float* tmpBuf_{nullptr};
+  float* oddHmBuf_{nullptr};
+  int* silenceCounts_{nullptr};
+  FIR* ambiFir_{nullptr};
+
+#ifndef TBE_DISABLE_PROFILING
+  ConvolutionProfiler profiler_;
+#endif
+  DeadlineMonitor deadlineMonitor_;
+
+  void init(Arena& arena);
 
-  FBDSP dsp_;
-  std::unique_ptr<float[]> tmpBuf_;
-  std::unique_ptr<float[]> oddHmBuf_;
-  std::unique_ptr<int[]> silenceCounts_;
-  std::vector<TBE::FIR> ambiFir_;
+  // A headLockedIn view without channels means no head-locked input
+  void processImpl(
+      const ConstAudioBufferView& ambisonicIn,
+      const AudioBufferView& binauralOut,
+      const ConstAudioBufferView& headLockedIn,
+      float headLockedGain);
 };
 } // namespace TBE
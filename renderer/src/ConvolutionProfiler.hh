@@ -0,0 +1,175 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "../../dsp/src/SeqLockSnapshot.hh"
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+namespace TBE {
+/// Harmonics with their own counters, enough for 7th order. Higher harmonics only count towards
+/// the stage totals.
+static const int kMaxProfiledHarmonics = 64;
+
+/// The parts of AmbiSphericalConvolution::process that are timed separately
+enum class ConvolutionStage {
+  /// Clearing the ear sums and the output of each harmonic FIR
+  CLEAR = 0,
+  /// Seeding the ear sums with the head-locked stereo input
+  HEAD_LOCKED_MIX,
+  /// Checking whether a harmonic can be skipped
+  SILENCE_CHECK,
+  FIR,
+  /// Adding each harmonic to the even or odd sum
+  ACCUMULATE,
+  /// Building the left and right ears from the sums
+  EAR_MIX,
+  COUNT
+};
+
+/// Counters accumulated by AmbiSphericalConvolution while profiling is enabled. All times are in
+/// nanoseconds of the steady clock.
+struct ConvolutionStats {
+  uint64_t numBlocks;
+  uint64_t numSamples;
+  uint64_t stageNs[static_cast<int>(ConvolutionStage::COUNT)];
+  /// Time spent on each harmonic: clearing, silence check, FIR and accumulation
+  uint64_t harmonicNs[kMaxProfiledHarmonics];
+  /// Time spent in the FIR of each harmonic
+  uint64_t harmonicFirNs[kMaxProfiledHarmonics];
+  /// Number of blocks in which the harmonic was skipped as silent
+  uint64_t harmonicSkips[kMaxProfiledHarmonics];
+  /// Harmonics run through their FIR and skipped, over all blocks
+  uint64_t numProcessedHarmonics;
+  uint64_t numSkippedHarmonics;
+
+  uint64_t getStageNs(ConvolutionStage stage) const {
+    return stageNs[static_cast<int>(stage)];
+  }
+
+  uint64_t getTotalNs() const {
+    uint64_t total = 0;
+    for (int stage = 0; stage < static_cast<int>(ConvolutionStage::COUNT); ++stage) {
+      total += stageNs[stage];
+    }
+    return total;
+  }
+};
+
+/// Collects ConvolutionStats on the audio thread and publishes them once per block for readers on
+/// other threads. Timing a stage is a clock read and two additions. Enabling, disabling, reading
+/// and resetting are lock-free and may happen on any thread.
+class ConvolutionProfiler {
+ public:
+  ConvolutionProfiler() {
+    memset(&stats_, 0, sizeof(stats_));
+  }
+
+  void setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool isEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /// Zero the counters when the next block starts
+  void reset() {
+    resetRequested_.store(true, std::memory_order_relaxed);
+  }
+
+  /// \return The counters as of the end of the last profiled block
+  ConvolutionStats getStats() const {
+    return snapshot_.read();
+  }
+
+  //
+  // Audio thread only
+  //
+
+  void beginBlock() {
+    if (resetRequested_.exchange(false, std::memory_order_relaxed)) {
+      memset(&stats_, 0, sizeof(stats_));
+    }
+    last_ = now();
+  }
+
+  /// Charge the time since the previous lap to a stage
+  void lap(ConvolutionStage stage) {
+    const uint64_t time = now();
+    stats_.stageNs[static_cast<int>(stage)] += time - last_;
+    last_ = time;
+  }
+
+  /// Charge the time since the previous lap to a stage and a harmonic
+  void lap(ConvolutionStage stage, int harmonic) {
+    const uint64_t time = now();
+    const uint64_t elapsed = time - last_;
+    const bool hasCounters = harmonic < kMaxProfiledHarmonics;
+    stats_.stageNs[static_cast<int>(stage)] += elapsed;
+    if (hasCounters) {
+      stats_.harmonicNs[harmonic] += elapsed;
+    }
+    if (stage == ConvolutionStage::FIR) {
+      if (hasCounters) {
+        stats_.harmonicFirNs[harmonic] += elapsed;
+      }
+      stats_.numProcessedHarmonics++;
+    }
+    last_ = time;
+  }
+
+  void skipped(int harmonic) {
+    if (harmonic < kMaxProfiledHarmonics) {
+      stats_.harmonicSkips[harmonic]++;
+    }
+    stats_.numSkippedHarmonics++;
+  }
+
+  void endBlock(int numSamples) {
+    stats_.numBlocks++;
+    stats_.numSamples += numSamples;
+    snapshot_.publish(stats_);
+  }
+
+ private:
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<bool> resetRequested_{false};
+  uint64_t last_{0};
+  // Owned by the audio thread, copied to snapshot_ at the end of each block
+  ConvolutionStats stats_;
+  SeqLockSnapshot<ConvolutionStats> snapshot_;
+};
+} // namespace TBE
+
+//
+// Instrumentation of a processing loop. With TBE_DISABLE_PROFILING the profiler is compiled out
+// and the macros expand to nothing; otherwise each is a branch on a pointer that is null while
+// profiling is disabled.
+//
+#ifndef TBE_DISABLE_PROFILING
+#define TBE_PROFILE(profiler, call) \
+  do {                              \
+    if (profiler) {                 \
+      (profiler)->call;             \
+    }                               \
+  } while (0)
+#else
+#define TBE_PROFILE(profiler, call) \
+  do {                              \
+  } while (0)
+#endif
@@ -0,0 +1,313 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "../../../dsp/src/AudioBufferList.hh"
+#include "../../../dsp/src/bench/Accuracy.hh"
+#include "../../../dsp/src/bench/BenchUtils.hh"
+#include "../AmbiBinauralCoefficients2OA.hh"
+#include "../AmbiBinauralCoefficients3OA.hh"
+#include "../AmbiSphericalConvolution.hh"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+//
+// Accuracy against speed of the rendering engines. Reference signals are rendered through a
+// double precision direct convolution and through every FIR path and AmbiSphericalConvolution,
+// and each configuration reports the SNR and the largest sample error against the reference, the
+// interaural level and time differences for the binaural renderer, and the time per sample. A new
+// engine or performance mode can be signed off by comparing its rows with the existing ones. Run
+// with --json for a document that can be stored, see BenchUtils.hh for the other options.
+//
+namespace TBE {
+namespace {
+const double kPi = 3.14159265358979323846;
+
+enum class Signal {
+  // Uniform white noise
+  NOISE,
+  // Exponential sine sweep from 20 Hz to 20 kHz
+  SWEEP,
+  // A click every 100 ms
+  IMPULSES,
+};
+
+const char* signalName(Signal signal) {
+  switch (signal) {
+    case Signal::NOISE:
+      return "noise";
+    case Signal::SWEEP:
+      return "sweep";
+    case Signal::IMPULSES:
+      return "impulses";
+  }
+  return "unknown";
+}
+
+std::vector<float> makeSignal(Signal signal, size_t numSamples, float sampleRate) {
+  std::vector<float> samples(numSamples, 0.f);
+  const double duration = numSamples / static_cast<double>(sampleRate);
+  const double rate = std::log(20000.0 / 20.0) / duration;
+  for (size_t i = 0; i < numSamples; ++i) {
+    const double t = i / static_cast<double>(sampleRate);
+    switch (signal) {
+      case Signal::NOISE:
+        samples[i] = 0.5f * (2.f * std::rand() / RAND_MAX - 1.f);
+        break;
+      case Signal::SWEEP:
+        samples[i] = static_cast<float>(
+            0.5 * std::sin(2.0 * kPi * 20.0 * (std::exp(rate * t) - 1.0) / rate));
+        break;
+      case Signal::IMPULSES:
+        samples[i] = i % static_cast<size_t>(0.1f * sampleRate) == 0 ? 0.5f : 0.f;
+        break;
+    }
+  }
+  return samples;
+}
+
+//
+// Every FIR path on noise, for several tap counts and block sizes. The blocks are processed one
+// after the other, so the error includes the delay line carried over between them.
+//
+void checkFIR(const Bench::Options& options, Bench::Report& report) {
+  const float kSampleRate = 48000.f;
+  const size_t numSamples = options.quick ? 4800 : 24000;
+  const std::vector<size_t> tapCounts =
+      options.quick ? std::vector<size_t>{100} : std::vector<size_t>{16, 100, 512, 2048};
+  const std::vector<size_t> blockSizes =
+      options.quick ? std::vector<size_t>{64} : std::vector<size_t>{1, 64, 512};
+
+  struct Path {
+    std::string name;
+    std::string tier;
+    CPU::Tier cpuTier;
+    bool linear;
+  };
+  std::vector<Path> paths;
+  paths.push_back({"FIR::processLinear", "linear", CPU::Tier::SCALAR, true});
+  for (CPU::Tier tier : CPU::supportedTiers()) {
+    paths.push_back({"FIR::process", CPU::tierName(tier), tier, false});
+  }
+
+  const std::vector<float> input = makeSignal(Signal::NOISE, numSamples, kSampleRate);
+  std::vector<float> output(numSamples);
+  for (size_t numTaps : tapCounts) {
+    // Decaying noise, like a room or HRTF response
+    std::vector<float> ir(numTaps);
+    for (size_t i = 0; i < numTaps; ++i) {
+      ir[i] = 0.2f * (2.f * std::rand() / RAND_MAX - 1.f) * std::exp(-4.f * i / numTaps);
+    }
+    const std::vector<double> reference =
+        Bench::directConvolution(input.data(), numSamples, ir.data(), numTaps);
+
+    for (const Path& path : paths) {
+      if (!Bench::selected(options, path.name)) {
+        continue;
+      }
+      for (size_t blockSize : blockSizes) {
+        FIR fir(ir.data(), numTaps);
+        const auto render = [&]() {
+          for (size_t offset = 0; offset < numSamples; offset += blockSize) {
+            const size_t len = std::min(blockSize, numSamples - offset);
+            if (path.linear) {
+              fir.processLinear(input.data() + offset, output.data() + offset, len);
+            } else {
+#ifdef TBE_STATIC_ISA
+              fir.process(input.data() + offset, output.data() + offset, len);
+#else
+              fir.process(path.cpuTier, input.data() + offset, output.data() + offset, len);
+#endif
+            }
+          }
+        };
+        render();
+        const Bench::SignalError error =
+            Bench::compareSignals(reference.data(), output.data(), numSamples);
+        const double ns = Bench::measure(render, options.minTimeMs);
+
+        report.add(Bench::Result(path.name)
+                       .set("tier", path.tier)
+                       .set("taps", static_cast<double>(numTaps))
+                       .set("block", static_cast<double>(blockSize))
+                       .set("signal", signalName(Signal::NOISE))
+                       .set("snr_db", error.snrDb)
+                       .set("max_error", error.maxError)
+                       .set("ns_per_sample", ns / numSamples));
+      }
+    }
+  }
+}
+
+/// \return The ambiX (ACN, SN3D) gains of a source in the horizontal plane. Positive azimuths are
+/// to the left.
+std::vector<float> encodeHorizontal(int order, double azimuthDegrees) {
+  const double azimuth = azimuthDegrees * kPi / 180.0;
+  std::vector<float> gains((order + 1) * (order + 1), 0.f);
+  for (int l = 0; l <= order; ++l) {
+    for (int m = -l; m <= l; ++m) {
+      const int absM = std::abs(m);
+      // The associated Legendre function at zero elevation, without the Condon-Shortley phase:
+      // P_m^m(0) = (2m - 1)!!, P_(m+1)^m(0) = 0 and P_l^m(0) = -(l + m - 1) / (l - m) P_(l-2)^m(0)
+      double legendre = 0.0;
+      if ((l - absM) % 2 == 0) {
+        legendre = 1.0;
+        for (int k = 1; k <= absM; ++k) {
+          legendre *= 2 * k - 1;
+        }
+        for (int n = absM + 2; n <= l; n += 2) {
+          legendre *= -static_cast<double>(n + absM - 1) / (n - absM);
+        }
+      }
+      double factorialRatio = 1.0;
+      for (int k = l - absM + 1; k <= l + absM; ++k) {
+        factorialRatio /= k;
+      }
+      const double sn3d = std::sqrt((m == 0 ? 1.0 : 2.0) * factorialRatio);
+      const double angular = m < 0 ? std::sin(absM * azimuth) : std::cos(m * azimuth);
+      gains[l * l + l + m] = static_cast<float>(sn3d * legendre * angular);
+    }
+  }
+  return gains;
+}
+
+AmbisonicIRContainer impulseResponse(int order, float sampleRate) {
+  return order == 2 ? get2OAAmbisonicImpulseResponse(sampleRate)
+                    : get3OAAmbisonicImpulseResponse(sampleRate);
+}
+
+//
+// AmbiSphericalConvolution on sources panned around the listener. The reference convolves each
+// harmonic of the same float input in double precision and builds the ears the way the renderer
+// does: left = even + odd and right = even - odd, with the odd sum over the harmonics with m < 0.
+//
+void checkRenderer(const Bench::Options& options, Bench::Report& report) {
+  const int orders[] = {2, 3};
+  const std::vector<float> sampleRates =
+      options.quick ? std::vector<float>{48000.f} : std::vector<float>{44100.f, 48000.f};
+  const std::vector<double> azimuths = options.quick
+      ? std::vector<double>{90.0}
+      : std::vector<double>{0.0, 30.0, 90.0, -90.0, 135.0};
+  const std::vector<Signal> signals = options.quick
+      ? std::vector<Signal>{Signal::NOISE}
+      : std::vector<Signal>{Signal::NOISE, Signal::SWEEP, Signal::IMPULSES};
+  const std::vector<int32_t> blockSizes =
+      options.quick ? std::vector<int32_t>{256} : std::vector<int32_t>{64, 256, 1024};
+  const float seconds = options.quick ? 0.1f : 0.5f;
+
+  for (int order : orders) {
+    const std::string name = std::to_string(order) + "OA";
+    if (!Bench::selected(options, name)) {
+      continue;
+    }
+    for (float sampleRate : sampleRates) {
+      const AmbisonicIRContainer irs = impulseResponse(order, sampleRate);
+      const int32_t numSamples = static_cast<int32_t>(seconds * sampleRate);
+      // Interaural delays stay well below 1 ms
+      const int maxLag = static_cast<int>(0.001f * sampleRate);
+      AudioBufferList input(numSamples, irs.numHarmonics);
+      AudioBufferList output(numSamples, 2);
+
+      for (Signal signal : signals) {
+        const std::vector<float> mono = makeSignal(signal, numSamples, sampleRate);
+        for (double azimuth : azimuths) {
+          const std::vector<float> gains = encodeHorizontal(order, azimuth);
+          std::vector<double> even(numSamples, 0.0);
+          std::vector<double> odd(numSamples, 0.0);
+          for (int l = 0; l <= order; ++l) {
+            for (int m = -l; m <= l; ++m) {
+              const int hm = l * l + l + m;
+              float* data = input.getChannelDataToWrite(hm);
+              for (int32_t i = 0; i < numSamples; ++i) {
+                data[i] = gains[hm] * mono[i];
+              }
+              const std::vector<double> convolved =
+                  Bench::directConvolution(data, numSamples, irs.ir[hm], irs.numTapsVec[hm]);
+              std::vector<double>& sum = m < 0 ? odd : even;
+              for (int32_t i = 0; i < numSamples; ++i) {
+                sum[i] += convolved[i];
+              }
+            }
+          }
+          std::vector<double> referenceLeft(numSamples);
+          std::vector<double> referenceRight(numSamples);
+          for (int32_t i = 0; i < numSamples; ++i) {
+            referenceLeft[i] = even[i] + odd[i];
+            referenceRight[i] = even[i] - odd[i];
+          }
+          const double referenceIld = Bench::interauralLevelDifferenceDb(
+              referenceLeft.data(), referenceRight.data(), numSamples);
+          const double referenceItd = Bench::interauralTimeDifference(
+              referenceLeft.data(), referenceRight.data(), numSamples, maxLag);
+
+          for (int32_t blockSize : blockSizes) {
+            AmbiSphericalConvolution renderer(blockSize, irs);
+            const auto render = [&]() {
+              for (int32_t offset = 0; offset < numSamples; offset += blockSize) {
+                const int32_t len = std::min(blockSize, numSamples - offset);
+                renderer.process(
+                    input.view().samples(offset, len), output.view().samples(offset, len));
+              }
+            };
+            render();
+            const float* left = output.getChannelDataToRead(0);
+            const float* right = output.getChannelDataToRead(1);
+            Bench::ErrorAccumulator error;
+            error.add(referenceLeft.data(), left, numSamples);
+            error.add(referenceRight.data(), right, numSamples);
+            const double ild = Bench::interauralLevelDifferenceDb(left, right, numSamples);
+            const double itd = Bench::interauralTimeDifference(left, right, numSamples, maxLag);
+            const double ns = Bench::measure(render, options.minTimeMs);
+
+            report.add(Bench::Result(name)
+                           .set("tier", CPU::tierName(CPU::selectedTier()))
+                           .set("sample_rate", sampleRate)
+                           .set("block", static_cast<double>(blockSize))
+                           .set("signal", signalName(signal))
+                           .set("azimuth", azimuth)
+                           .set("snr_db", error.get().snrDb)
+                           .set("max_error", error.get().maxError)
+                           .set("ild_db", ild)
+                           .set("ild_error_db", ild - referenceIld)
+                           .set("itd_us", 1e6 * itd / sampleRate)
+                           .set("itd_error_us", 1e6 * (itd - referenceItd) / sampleRate)
+                           .set("ns_per_sample", ns / numSamples));
+          }
+        }
+      }
+    }
+  }
+}
+} // namespace
+} // namespace TBE
+
+int main(int argc, char** argv) {
+  TBE::Bench::Options options;
+  if (!TBE::Bench::parseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  // Speed is reported for context, accuracy is what this app is about
+  options.counters = false;
+
+  TBE::Bench::Report report("FBAudioRenderer-accuracy", options);
+  report.context()
+      .set("selected_tier", TBE::CPU::tierName(TBE::CPU::selectedTier()))
+#ifdef TBE_STATIC_ISA
+      .set("dispatch", "static")
+#else
+      .set("dispatch", "runtime")
+#endif
+      .set("max_snr_db", TBE::Bench::kMaxSnrDb)
+      .set("min_time_ms", options.minTimeMs);
+
+  TBE::checkFIR(options, report);
+  TBE::checkRenderer(options, report);
+  report.finish();
+  return 0;
+}
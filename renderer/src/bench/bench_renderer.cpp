@@ -0,0 +1,153 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "../../../dsp/src/AudioBufferList.hh"
+#include "../../../dsp/src/bench/BenchUtils.hh"
+#include "../AmbiBinauralCoefficients2OA.hh"
+#include "../AmbiBinauralCoefficients3OA.hh"
+#include "../AmbiSphericalConvolution.hh"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+//
+// End-to-end cost of binaural rendering with AmbiSphericalConvolution: a few seconds of Ambisonic
+// input are rendered block by block and the time is reported per sample, as a real-time factor
+// and as the number of streams a single core could render, next to the memory of each stream.
+// Run with --json for a document that can be stored and compared between builds, see
+// BenchUtils.hh for the other options.
+//
+namespace TBE {
+namespace {
+enum class Sparsity {
+  // Noise on every harmonic
+  ALL_HARMONICS,
+  // Only the first order carries content, the upper orders are silent
+  SILENT_UPPER_ORDERS,
+  // Noise on every harmonic for 250 ms, then 250 ms of silence, and so on
+  INTERMITTENT,
+};
+
+const char* sparsityName(Sparsity sparsity) {
+  switch (sparsity) {
+    case Sparsity::ALL_HARMONICS:
+      return "all_harmonics";
+    case Sparsity::SILENT_UPPER_ORDERS:
+      return "silent_upper_orders";
+    case Sparsity::INTERMITTENT:
+      return "intermittent";
+  }
+  return "unknown";
+}
+
+void fillInput(AudioBufferList& input, Sparsity sparsity, float sampleRate) {
+  const int32_t kFirstOrderHarmonics = 4;
+  const int32_t period = static_cast<int32_t>(0.25f * sampleRate);
+  input.zero();
+  for (int32_t hm = 0; hm < input.getNumOfChannels(); ++hm) {
+    if (sparsity == Sparsity::SILENT_UPPER_ORDERS && hm >= kFirstOrderHarmonics) {
+      continue;
+    }
+    float* data = input.getChannelDataToWrite(hm);
+    for (int32_t i = 0; i < input.getSamplesPerChannel(); ++i) {
+      if (sparsity == Sparsity::INTERMITTENT && (i / period) % 2 == 1) {
+        continue;
+      }
+      data[i] = 0.25f * (2.f * std::rand() / RAND_MAX - 1.f);
+    }
+  }
+}
+
+AmbisonicIRContainer impulseResponse(int order, float sampleRate) {
+  return order == 2 ? get2OAAmbisonicImpulseResponse(sampleRate)
+                    : get3OAAmbisonicImpulseResponse(sampleRate);
+}
+
+void benchRenderer(const Bench::Options& options, Bench::Report& report) {
+  const int orders[] = {2, 3};
+  const float sampleRates[] = {44100.f, 48000.f};
+  const Sparsity patterns[] = {
+      Sparsity::ALL_HARMONICS, Sparsity::SILENT_UPPER_ORDERS, Sparsity::INTERMITTENT};
+  const std::vector<int32_t> blockSizes = options.quick
+      ? std::vector<int32_t>{256, 1024}
+      : std::vector<int32_t>{64, 128, 256, 512, 1024, 2048};
+  const float seconds = options.quick ? 0.5f : 2.f;
+
+  for (int order : orders) {
+    const std::string name = std::to_string(order) + "OA";
+    if (!Bench::selected(options, name)) {
+      continue;
+    }
+    for (float sampleRate : sampleRates) {
+      const AmbisonicIRContainer irs = impulseResponse(order, sampleRate);
+      const int32_t numSamples = static_cast<int32_t>(seconds * sampleRate);
+      AudioBufferList input(numSamples, irs.numHarmonics);
+      AudioBufferList output(numSamples, 2);
+
+      for (Sparsity sparsity : patterns) {
+        fillInput(input, sparsity, sampleRate);
+
+        for (int32_t blockSize : blockSizes) {
+          AmbiSphericalConvolution renderer(blockSize, irs);
+          // Render the whole input, one host block at a time
+          size_t numCalls = 0;
+          const double ns = Bench::measure(
+              [&]() {
+                for (int32_t offset = 0; offset < numSamples; offset += blockSize) {
+                  const int32_t len = std::min(blockSize, numSamples - offset);
+                  renderer.process(
+                      input.view().samples(offset, len), output.view().samples(offset, len));
+                }
+              },
+              options.minTimeMs,
+              &numCalls,
+              report.counters());
+
+          const int32_t blocksPerCall = (numSamples + blockSize - 1) / blockSize;
+          const double realTimeFactor = seconds * 1e9 / ns;
+          const MemoryFootprint footprint = renderer.memoryFootprint();
+          report.add(Bench::Result(name)
+                         .set("sample_rate", sampleRate)
+                         .set("block", static_cast<double>(blockSize))
+                         .set("sparsity", sparsityName(sparsity))
+                         .set("ns_per_sample", ns / numSamples)
+                         .set("ns_per_block", ns * blockSize / numSamples)
+                         .set("realtime_factor", realTimeFactor)
+                         .set("streams_per_core", std::floor(realTimeFactor))
+                         .set("private_bytes", static_cast<double>(footprint.getPrivate()))
+                         .set("shared_bytes", static_cast<double>(footprint.getShared()))
+                         .setCounters(report.counters(), numCalls * blocksPerCall));
+        }
+      }
+    }
+  }
+}
+} // namespace
+} // namespace TBE
+
+int main(int argc, char** argv) {
+  TBE::Bench::Options options;
+  if (!TBE::Bench::parseOptions(argc, argv, &options)) {
+    return 1;
+  }
+
+  TBE::Bench::Report report("FBAudioRenderer-bench", options);
+  report.context()
+      .set("tier", TBE::CPU::tierName(TBE::CPU::selectedTier()))
+#ifdef TBE_STATIC_ISA
+      .set("dispatch", "static")
+#else
+      .set("dispatch", "runtime")
+#endif
+      .set("min_time_ms", options.minTimeMs);
+
+  TBE::benchRenderer(options, report);
+  report.finish();
+  return 0;
+}
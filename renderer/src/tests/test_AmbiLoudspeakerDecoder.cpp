@@ -0,0 +1,148 @@
+/*
+ Copyright (c) 2018-present, Facebook, Inc.
+
+ This source code is licensed under the MIT license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include "../../../dsp/src/AudioBufferList.hh"
+#include "../AmbiLoudspeakerDecoder.hh"
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+namespace TBE {
+static const LoudspeakerPosition kOctahedron[6] =
+    {{0.f, 0.f}, {90.f, 0.f}, {180.f, 0.f}, {-90.f, 0.f}, {0.f, 90.f}, {0.f, -90.f}};
+
+TEST(AmbiLoudspeakerDecoder, computeSN3DFirstOrder) {
+  double coefs[4];
+  const float az = 30.f;
+  const float el = 20.f;
+  AmbiLoudspeakerDecoder::computeSN3D(1, az, el, coefs);
+
+  const double azRad = az * M_PI / 180.0;
+  const double elRad = el * M_PI / 180.0;
+  EXPECT_NEAR(coefs[0], 1.0, 1e-9); // W
+  EXPECT_NEAR(coefs[1], std::sin(azRad) * std::cos(elRad), 1e-9); // Y
+  EXPECT_NEAR(coefs[2], std::sin(elRad), 1e-9); // Z
+  EXPECT_NEAR(coefs[3], std::cos(azRad) * std::cos(elRad), 1e-9); // X
+}
+
+TEST(AmbiLoudspeakerDecoder, computeSN3DSecondOrder) {
+  double coefs[9];
+  AmbiLoudspeakerDecoder::computeSN3D(2, 90.f, 0.f, coefs);
+
+  // Hard left on the horizontal plane, matching the panning gains used in the binaural tests
+  const double expected[9] = {1.0, 1.0, 0.0, 0.0, 0.0, 0.0, -0.5, 0.0, -std::sqrt(3.0) / 2.0};
+  for (int hm = 0; hm < 9; ++hm) {
+    EXPECT_NEAR(coefs[hm], expected[hm], 1e-6) << " Harmonic " << hm;
+  }
+}
+
+TEST(AmbiLoudspeakerDecoder, modeMatchingReencodes) {
+  AmbiLoudspeakerDecoder decoder(AmbisonicOrder::ORDER_1OA, kOctahedron, 6);
+  ASSERT_EQ(decoder.getNumHarmonics(), 4u);
+  ASSERT_EQ(decoder.getNumSpeakers(), 6u);
+
+  // Encoding the decoded speaker feeds again must give back the original harmonics
+  const float* D = decoder.getDecodingMatrix();
+  for (size_t a = 0; a < 4; ++a) {
+    for (size_t b = 0; b < 4; ++b) {
+      double sum = 0.0;
+      for (size_t s = 0; s < 6; ++s) {
+        double coefs[4];
+        AmbiLoudspeakerDecoder::computeSN3D(
+            1, kOctahedron[s].azimuth, kOctahedron[s].elevation, coefs);
+        sum += coefs[a] * D[s * 4 + b];
+      }
+      EXPECT_NEAR(sum, a == b ? 1.0 : 0.0, 1e-5) << a << ", " << b;
+    }
+  }
+}
+
+TEST(AmbiLoudspeakerDecoder, fewerSpeakersThanHarmonics) {
+  const LoudspeakerPosition quad[4] = {{45.f, 0.f}, {135.f, 0.f}, {-135.f, 0.f}, {-45.f, 0.f}};
+  AmbiLoudspeakerDecoder decoder(AmbisonicOrder::ORDER_2OA, quad, 4);
+
+  // A plane wave from a speaker direction is reproduced by that speaker alone
+  const float* D = decoder.getDecodingMatrix();
+  for (size_t src = 0; src < 4; ++src) {
+    double coefs[9];
+    AmbiLoudspeakerDecoder::computeSN3D(2, quad[src].azimuth, quad[src].elevation, coefs);
+    for (size_t s = 0; s < 4; ++s) {
+      double gain = 0.0;
+      for (size_t h = 0; h < 9; ++h) {
+        gain += D[s * 9 + h] * coefs[h];
+      }
+      EXPECT_NEAR(gain, s == src ? 1.0 : 0.0, 1e-5) << src << ", " << s;
+    }
+  }
+}
+
+TEST(AmbiLoudspeakerDecoder, process) {
+  const int kBufferSize = 37;
+  AmbiLoudspeakerDecoder decoder(AmbisonicOrder::ORDER_1OA, kOctahedron, 6);
+  AudioBufferList input(kBufferSize, 4);
+  AudioBufferList output(kBufferSize, 6);
+
+  // Noise panned to the front
+  double coefs[4];
+  AmbiLoudspeakerDecoder::computeSN3D(1, 0.f, 0.f, coefs);
+  for (int i = 0; i < kBufferSize; ++i) {
+    const float sample = 2.f * std::rand() / RAND_MAX - 1.f;
+    for (int hm = 0; hm < 4; ++hm) {
+      input.getChannelDataToWrite(hm)[i] = sample * static_cast<float>(coefs[hm]);
+    }
+  }
+
+  decoder.process(input.getDataReadOnly(), output.getData(), kBufferSize);
+
+  const float* D = decoder.getDecodingMatrix();
+  for (int s = 0; s < 6; ++s) {
+    for (int i = 0; i < kBufferSize; ++i) {
+      float expected = 0.f;
+      for (int hm = 0; hm < 4; ++hm) {
+        expected += D[s * 4 + hm] * input.getChannelDataToRead(hm)[i];
+      }
+      ASSERT_NEAR(output.getChannelDataToRead(s)[i], expected, 1e-5f);
+    }
+  }
+
+  // The front speaker carries most of the signal
+  EXPECT_GT(output.getRMS(0), 0.1f);
+  for (int s = 1; s < 6; ++s) {
+    EXPECT_GT(output.getRMS(0), output.getRMS(s));
+  }
+}
+
+TEST(AmbiLoudspeakerDecoder, processViews) {
+  const int kBufferSize = 64;
+  AmbiLoudspeakerDecoder decoder(AmbisonicOrder::ORDER_1OA, kOctahedron, 6);
+  // A bed with two extra channels in front of the Ambisonic ones
+  AudioBufferList bed(kBufferSize, 6);
+  AudioBufferList output(kBufferSize, 6);
+  AudioBufferList reference(kBufferSize, 6);
+  for (int c = 0; c < 6; ++c) {
+    for (int i = 0; i < kBufferSize; ++i) {
+      bed.getChannelDataToWrite(c)[i] = 2.f * std::rand() / RAND_MAX - 1.f;
+    }
+  }
+
+  const float** ambisonic = bed.getDataReadOnly() + 2;
+  decoder.process(ambisonic, reference.getData(), kBufferSize);
+
+  // Decode in blocks straight out of the bed
+  ConstAudioBufferView ambisonicView = bed.view().channels(2, 4);
+  for (int offset = 0; offset < kBufferSize; offset += 24) {
+    const int len = std::min(24, kBufferSize - offset);
+    decoder.process(ambisonicView.samples(offset, len), output.view().samples(offset, len));
+  }
+
+  for (int s = 0; s < 6; ++s) {
+    for (int i = 0; i < kBufferSize; ++i) {
+      ASSERT_NEAR(output.getChannelDataToRead(s)[i], reference.getChannelDataToRead(s)[i], 1e-6f);
+    }
+  }
+}
+} // namespace TBE
@@ -6,12 +6,18 @@
  */
 
 #include "../../../dsp/src/AudioBufferList.hh"
+#include "../../../dsp/src/BlockSizeAdapter.hh"
+#include "../../../dsp/src/tests/HeapGuard.hh"
 #include "../AmbiBinauralCoefficients2OA.hh"
 #include "../AmbiBinauralCoefficients3OA.hh"
 #include "../AmbiSphericalConvolution.hh"
 #include "gtest/gtest.h"
 
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 namespace TBE {
 static const int kNumTestTaps[16] =
@@ -218,6 +224,86 @@ TEST_F(AmbiSphericalConvolutionTest, processDiracFrontTest) {
   EXPECT_LT(std::abs(left - right), kRMSdBToleranceSame_);
 }
 
+TEST_F(AmbiSphericalConvolutionTest, headLockedStereo) {
+  const float ambi_pan_left[kNum2OAHarmonics] = {
+      1.f, 1.f, 0.f, 0.f, 0.f, 0.f, -0.5f, 0.f, -kSqrt3Over2_};
+  const float kHeadLockedGain = 0.5f;
+
+  AmbiSphericalConvolution sph_rend(
+      kMaxBufferSize, get2OAAmbisonicImpulseResponse(kTestSampleRate_));
+  AmbiSphericalConvolution sph_rend_reference(
+      kMaxBufferSize, get2OAAmbisonicImpulseResponse(kTestSampleRate_));
+
+  writeNoiseTo2OAInputBuffer(ambi_pan_left);
+
+  AudioBufferList headLocked(kMaxBufferSize, kStereoNumChannels);
+  AudioBufferList referenceOut(kMaxBufferSize, kStereoNumChannels);
+  for (int i = 0; i < kMaxBufferSize; i++) {
+    headLocked.getChannelDataToWrite(0)[i] = noise_[kMaxBufferSize - 1 - i];
+    headLocked.getChannelDataToWrite(1)[i] = -0.5f * noise_[i];
+  }
+
+  for (int block = 0; block < 2; block++) {
+    sph_rend.process(
+        input2OABuf_.getDataReadOnly(),
+        binauralOutBuffer_.getData(),
+        kMaxBufferSize,
+        headLocked.getDataReadOnly(),
+        kHeadLockedGain);
+    sph_rend_reference.process(
+        input2OABuf_.getDataReadOnly(), referenceOut.getData(), kMaxBufferSize);
+
+    for (int ch = 0; ch < kStereoNumChannels; ch++) {
+      for (int i = 0; i < kMaxBufferSize; i++) {
+        const float expected = referenceOut.getChannelDataToRead(ch)[i] +
+            kHeadLockedGain * headLocked.getChannelDataToRead(ch)[i];
+        ASSERT_NEAR(binauralOutBuffer_.getChannelDataToRead(ch)[i], expected, 1e-5f)
+            << " Channel " << ch << " Idx " << i;
+      }
+    }
+  }
+
+  // Silent Ambisonic input leaves only the head-locked signal
+  input2OABuf_.zero();
+  for (int block = 0; block < 3; block++) {
+    sph_rend.process(
+        input2OABuf_.getDataReadOnly(),
+        binauralOutBuffer_.getData(),
+        kMaxBufferSize,
+        headLocked.getDataReadOnly(),
+        kHeadLockedGain);
+  }
+  for (int ch = 0; ch < kStereoNumChannels; ch++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      ASSERT_NEAR(
+          binauralOutBuffer_.getChannelDataToRead(ch)[i],
+          kHeadLockedGain * headLocked.getChannelDataToRead(ch)[i],
+          1e-6f);
+    }
+  }
+}
+
+TEST_F(AmbiSphericalConvolutionTest, denormalProtection) {
+  AmbiSphericalConvolution sph_rend(
+      kMaxBufferSize, get2OAAmbisonicImpulseResponse(kTestSampleRate_));
+  EXPECT_TRUE(sph_rend.getDenormalProtection());
+
+  // A tail that has decayed into the denormal range renders to exact silence
+  for (int hm = 0; hm < kNum2OAHarmonics; hm++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      input2OABuf_.getChannelDataToWrite(hm)[i] = 1e-39f * noise_[i];
+    }
+  }
+  sph_rend.process(input2OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kMaxBufferSize);
+
+  for (int ch = 0; ch < kStereoNumChannels; ch++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      ASSERT_EQ(binauralOutBuffer_.getChannelDataToRead(ch)[i], 0.f)
+          << " Channel " << ch << " Idx " << i;
+    }
+  }
+}
+
 TEST_F(AmbiSphericalConvolutionTest, passThrough3OA) {
   AmbiSphericalConvolution sph_rend(
       kMaxBufferSize, get3OAAmbisonicImpulseResponse(kTestSampleRate_));
@@ -239,4 +325,384 @@ TEST_F(AmbiSphericalConvolutionTest, passThrough3OA) {
     EXPECT_GT(left + right, -55.f);
   }
 }
+
+TEST_F(AmbiSphericalConvolutionTest, arenaLayout) {
+  const AmbisonicIRContainer irs = get2OAAmbisonicImpulseResponse(kTestSampleRate_);
+  const size_t arenaSize = AmbiSphericalConvolution::arenaSize(kMaxBufferSize, irs);
+  Arena arena(arenaSize);
+
+  const float ambi_pan_left[kNum2OAHarmonics] = {
+      1.f, 1.f, 0.f, 0.f, 0.f, 0.f, -0.5f, 0.f, -kSqrt3Over2_};
+  writeNoiseTo2OAInputBuffer(ambi_pan_left);
+  AmbiSphericalConvolution reference(kMaxBufferSize, irs);
+  AudioBufferList referenceOut0(kMaxBufferSize, kStereoNumChannels);
+  AudioBufferList referenceOut1(kMaxBufferSize, kStereoNumChannels);
+  AudioBufferList* referenceOut[2] = {&referenceOut0, &referenceOut1};
+  for (int block = 0; block < 2; block++) {
+    reference.process(
+        input2OABuf_.getDataReadOnly(), referenceOut[block]->getData(), kMaxBufferSize);
+  }
+
+  // The pool is reused by a second renderer once the first one is gone
+  for (int instance = 0; instance < 2; instance++) {
+    arena.reset();
+    AmbiSphericalConvolution sph_rend(kMaxBufferSize, irs, arena);
+    EXPECT_EQ(arena.getUsed(), arenaSize);
+
+    for (int block = 0; block < 2; block++) {
+      sph_rend.process(
+          input2OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kMaxBufferSize);
+      for (int ch = 0; ch < kStereoNumChannels; ch++) {
+        for (int i = 0; i < kMaxBufferSize; i++) {
+          ASSERT_EQ(
+              binauralOutBuffer_.getChannelDataToRead(ch)[i],
+              referenceOut[block]->getChannelDataToRead(ch)[i]);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(AmbiSphericalConvolutionTest, memoryFootprint) {
+  const AmbisonicIRContainer irs = get3OAAmbisonicImpulseResponse(kTestSampleRate_);
+  size_t numTaps = 0;
+  for (int hm = 0; hm < irs.numHarmonics; hm++) {
+    numTaps += irs.numTapsVec[hm];
+  }
+
+  // Everything but the renderer object itself is in the arena
+  Arena arena(AmbiSphericalConvolution::arenaSize(kMaxBufferSize, irs));
+  AmbiSphericalConvolution sph_rend(kMaxBufferSize, irs, arena);
+  const MemoryFootprint footprint = sph_rend.memoryFootprint();
+  EXPECT_EQ(footprint.getPrivate(), arena.getUsed() + sizeof(AmbiSphericalConvolution));
+  EXPECT_EQ(footprint.coefficients.privateBytes, 0u);
+  EXPECT_GE(footprint.coefficients.sharedBytes, numTaps * sizeof(float));
+  EXPECT_GE(footprint.state.privateBytes, 2 * numTaps * sizeof(float));
+  EXPECT_EQ(footprint.scratch.privateBytes, 2 * kMaxBufferSize * sizeof(float));
+
+  // The own arena adds only the Arena object
+  AmbiSphericalConvolution owning(kMaxBufferSize, irs);
+  const MemoryFootprint owningFootprint = owning.memoryFootprint();
+  EXPECT_EQ(owningFootprint.getPrivate(), footprint.getPrivate() + sizeof(Arena));
+  EXPECT_EQ(owningFootprint.getShared(), footprint.getShared());
+}
+
+TEST_F(AmbiSphericalConvolutionTest, sharedIRs) {
+  const AmbisonicIRContainer irs = get3OAAmbisonicImpulseResponse(kTestSampleRate_);
+  const size_t numStored = SharedIR::numStored();
+  AmbiSphericalConvolution first(kMaxBufferSize, irs);
+  const size_t numHarmonicIRs = SharedIR::numStored() - numStored;
+  EXPECT_GT(numHarmonicIRs, 0u);
+  EXPECT_LE(numHarmonicIRs, static_cast<size_t>(irs.numHarmonics));
+
+  // More renderers on the same IRs add their delay lines, no taps
+  {
+    std::vector<std::unique_ptr<AmbiSphericalConvolution>> renderers;
+    for (int i = 0; i < 8; i++) {
+      renderers.emplace_back(new AmbiSphericalConvolution(kMaxBufferSize, irs));
+    }
+    EXPECT_EQ(SharedIR::numStored(), numStored + numHarmonicIRs);
+
+    // And render the same as the first one
+    const float ambi_pan_left[kNum3OAHarmonics] = {
+        1.f, 1.f, 0.f, 0.f, 0.f, 0.f, -0.5f, 0.f, -kSqrt3Over2_, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    for (int hm = 0; hm < kNum3OAHarmonics; hm++) {
+      for (int i = 0; i < kMaxBufferSize; i++) {
+        input3OABuf_.getChannelDataToWrite(hm)[i] = noise_[i] * ambi_pan_left[hm];
+      }
+    }
+    AudioBufferList expected(kMaxBufferSize, kStereoNumChannels);
+    first.process(input3OABuf_.getDataReadOnly(), expected.getData(), kMaxBufferSize);
+    renderers.back()->process(
+        input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kMaxBufferSize);
+    for (int ch = 0; ch < kStereoNumChannels; ch++) {
+      for (int i = 0; i < kMaxBufferSize; i++) {
+        ASSERT_EQ(
+            binauralOutBuffer_.getChannelDataToRead(ch)[i], expected.getChannelDataToRead(ch)[i]);
+      }
+    }
+  }
+  EXPECT_EQ(SharedIR::numStored(), numStored + numHarmonicIRs);
+}
+
+TEST_F(AmbiSphericalConvolutionTest, processDoesNotAllocate) {
+  AmbiSphericalConvolution sph_rend(
+      kMaxBufferSize, get3OAAmbisonicImpulseResponse(kTestSampleRate_));
+  AudioBufferList headLocked(kMaxBufferSize, kStereoNumChannels);
+  for (int hm = 0; hm < kNum3OAHarmonics; hm++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      input3OABuf_.getChannelDataToWrite(hm)[i] = noise_[i];
+    }
+  }
+
+  const int kBlockSizes[] = {1, 7, 64, 100, 101, 512, static_cast<int>(kMaxBufferSize)};
+  HeapGuard guard;
+  for (int bufferLength : kBlockSizes) {
+    sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), bufferLength);
+    sph_rend.process(
+        input3OABuf_.getDataReadOnly(),
+        binauralOutBuffer_.getData(),
+        bufferLength,
+        headLocked.getDataReadOnly(),
+        0.5f);
+  }
+  EXPECT_EQ(guard.numAllocations(), 0u);
+  EXPECT_EQ(guard.numDeallocations(), 0u);
+}
+
+TEST_F(AmbiSphericalConvolutionTest, processViews) {
+  const AmbisonicIRContainer irs = get2OAAmbisonicImpulseResponse(kTestSampleRate_);
+  AmbiSphericalConvolution sph_rend(kMaxBufferSize, irs);
+  AmbiSphericalConvolution sph_rend_reference(kMaxBufferSize, irs);
+
+  const float ambi_pan_left[kNum2OAHarmonics] = {
+      1.f, 1.f, 0.f, 0.f, 0.f, 0.f, -0.5f, 0.f, -kSqrt3Over2_};
+  writeNoiseTo2OAInputBuffer(ambi_pan_left);
+  AudioBufferList referenceOut(kMaxBufferSize, kStereoNumChannels);
+  AudioBufferList headLocked(kMaxBufferSize, kStereoNumChannels);
+  for (int i = 0; i < kMaxBufferSize; i++) {
+    headLocked.getChannelDataToWrite(0)[i] = noise_[i];
+    headLocked.getChannelDataToWrite(1)[i] = -noise_[i];
+  }
+
+  // Splitting the input into views of odd sized blocks renders the same signal
+  sph_rend_reference.process(
+      input2OABuf_.getDataReadOnly(),
+      referenceOut.getData(),
+      kMaxBufferSize,
+      headLocked.getDataReadOnly(),
+      0.25f);
+  const int kBlockSize = 100;
+  for (int offset = 0; offset < kMaxBufferSize; offset += kBlockSize) {
+    const int len = std::min<int>(kBlockSize, kMaxBufferSize - offset);
+    sph_rend.process(
+        input2OABuf_.view().samples(offset, len),
+        binauralOutBuffer_.view().samples(offset, len),
+        headLocked.view().samples(offset, len),
+        0.25f);
+  }
+
+  for (int ch = 0; ch < kStereoNumChannels; ch++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      ASSERT_NEAR(
+          binauralOutBuffer_.getChannelDataToRead(ch)[i],
+          referenceOut.getChannelDataToRead(ch)[i],
+          1e-5f)
+          << " Channel " << ch << " Idx " << i;
+    }
+  }
+}
+
+TEST_F(AmbiSphericalConvolutionTest, blockSizeAdapter) {
+  const AmbisonicIRContainer irs = get2OAAmbisonicImpulseResponse(kTestSampleRate_);
+  const int kBlockSize = 96;
+  AmbiSphericalConvolution sph_rend(kBlockSize, irs);
+  AmbiSphericalConvolution sph_rend_reference(kMaxBufferSize, irs);
+  BlockSizeAdapter<AmbiSphericalConvolution> adapter(
+      sph_rend, kNum2OAHarmonics, kStereoNumChannels, kBlockSize);
+
+  const float ambi_pan_left[kNum2OAHarmonics] = {
+      1.f, 1.f, 0.f, 0.f, 0.f, 0.f, -0.5f, 0.f, -kSqrt3Over2_};
+  writeNoiseTo2OAInputBuffer(ambi_pan_left);
+  AudioBufferList referenceOut(kMaxBufferSize, kStereoNumChannels);
+  sph_rend_reference.process(
+      input2OABuf_.getDataReadOnly(), referenceOut.getData(), kMaxBufferSize);
+
+  // Host callbacks larger and smaller than the block size of the renderer
+  const int kCallbackSizes[] = {1, 200, 96, 13, 500, 214};
+  int offset = 0;
+  for (int len : kCallbackSizes) {
+    adapter.process(
+        input2OABuf_.view().samples(offset, len), binauralOutBuffer_.view().samples(offset, len));
+    offset += len;
+  }
+  ASSERT_EQ(offset, static_cast<int>(kMaxBufferSize));
+
+  const int latency = adapter.getLatency();
+  for (int ch = 0; ch < kStereoNumChannels; ch++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      const float expected =
+          i < latency ? 0.f : referenceOut.getChannelDataToRead(ch)[i - latency];
+      ASSERT_NEAR(binauralOutBuffer_.getChannelDataToRead(ch)[i], expected, 1e-5f)
+          << " Channel " << ch << " Idx " << i;
+    }
+  }
+}
+
+TEST_F(AmbiSphericalConvolutionTest, profiling) {
+  AmbiSphericalConvolution sph_rend(
+      kMaxBufferSize, get3OAAmbisonicImpulseResponse(kTestSampleRate_));
+  EXPECT_FALSE(sph_rend.getProfilingEnabled());
+
+  // First order content only, the upper orders are silent
+  for (int hm = 0; hm < 4; hm++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      input3OABuf_.getChannelDataToWrite(hm)[i] = noise_[i];
+    }
+  }
+  const int kBlockSize = 256;
+  const int kNumBlocks = 10;
+  sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kBlockSize);
+  EXPECT_EQ(sph_rend.getStats().numBlocks, 0u);
+
+  sph_rend.setProfilingEnabled(true);
+#ifdef TBE_DISABLE_PROFILING
+  // Compiled out: nothing is ever counted
+  EXPECT_FALSE(sph_rend.getProfilingEnabled());
+  sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kBlockSize);
+  EXPECT_EQ(sph_rend.getStats().numBlocks, 0u);
+#else
+  EXPECT_TRUE(sph_rend.getProfilingEnabled());
+
+  // Poll from another thread while rendering, as telemetry would
+  std::atomic<bool> done{false};
+  std::atomic<int> numInconsistent{0};
+  std::thread poller([&]() {
+    while (!done.load()) {
+      const ConvolutionStats stats = sph_rend.getStats();
+      if (stats.numSamples != stats.numBlocks * kBlockSize ||
+          stats.numProcessedHarmonics + stats.numSkippedHarmonics !=
+              stats.numBlocks * kNum3OAHarmonics) {
+        numInconsistent++;
+      }
+    }
+  });
+
+  HeapGuard guard;
+  for (int block = 0; block < kNumBlocks; block++) {
+    sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kBlockSize);
+  }
+  EXPECT_EQ(guard.numAllocations(), 0u);
+  done = true;
+  poller.join();
+  EXPECT_EQ(numInconsistent.load(), 0);
+
+  ConvolutionStats stats = sph_rend.getStats();
+  EXPECT_EQ(stats.numBlocks, static_cast<uint64_t>(kNumBlocks));
+  EXPECT_EQ(stats.numSamples, static_cast<uint64_t>(kNumBlocks * kBlockSize));
+  EXPECT_GT(stats.getStageNs(ConvolutionStage::FIR), 0u);
+  EXPECT_EQ(stats.getStageNs(ConvolutionStage::HEAD_LOCKED_MIX), 0u);
+  EXPECT_GE(stats.getTotalNs(), stats.getStageNs(ConvolutionStage::FIR));
+
+  // The first call already counted one silent block, so the silent harmonics skip every block
+  for (int hm = 0; hm < kNum3OAHarmonics; hm++) {
+    if (hm < 4) {
+      EXPECT_EQ(stats.harmonicSkips[hm], 0u) << "Harmonic " << hm;
+      EXPECT_GT(stats.harmonicFirNs[hm], 0u) << "Harmonic " << hm;
+      EXPECT_GE(stats.harmonicNs[hm], stats.harmonicFirNs[hm]) << "Harmonic " << hm;
+    } else {
+      EXPECT_EQ(stats.harmonicSkips[hm], static_cast<uint64_t>(kNumBlocks)) << "Harmonic " << hm;
+      EXPECT_EQ(stats.harmonicFirNs[hm], 0u) << "Harmonic " << hm;
+    }
+  }
+  EXPECT_EQ(stats.numSkippedHarmonics, static_cast<uint64_t>(12 * kNumBlocks));
+  EXPECT_EQ(stats.numProcessedHarmonics, static_cast<uint64_t>(4 * kNumBlocks));
+
+  // Counters restart with the next block after a reset, and stop while disabled
+  sph_rend.resetStats();
+  sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kBlockSize);
+  EXPECT_EQ(sph_rend.getStats().numBlocks, 1u);
+  sph_rend.setProfilingEnabled(false);
+  sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kBlockSize);
+  EXPECT_EQ(sph_rend.getStats().numBlocks, 1u);
+#endif
+}
+
+#ifndef TBE_DISABLE_PROFILING
+TEST(ConvolutionProfiler, harmonicsPastTheCountersOnlyCountTowardsTheTotals) {
+  ConvolutionProfiler profiler;
+  profiler.beginBlock();
+  profiler.lap(ConvolutionStage::FIR, kMaxProfiledHarmonics - 1);
+  profiler.lap(ConvolutionStage::FIR, kMaxProfiledHarmonics);
+  profiler.skipped(kMaxProfiledHarmonics + 16);
+  profiler.endBlock(256);
+
+  const ConvolutionStats stats = profiler.getStats();
+  EXPECT_EQ(stats.numProcessedHarmonics, 2u);
+  EXPECT_EQ(stats.numSkippedHarmonics, 1u);
+  EXPECT_EQ(stats.harmonicSkips[kMaxProfiledHarmonics - 1], 0u);
+  EXPECT_GE(
+      stats.getStageNs(ConvolutionStage::FIR), stats.harmonicFirNs[kMaxProfiledHarmonics - 1]);
+}
+#endif
+
+TEST_F(AmbiSphericalConvolutionTest, deadlineMonitoring) {
+  AmbiSphericalConvolution sph_rend(
+      kMaxBufferSize, get3OAAmbisonicImpulseResponse(kTestSampleRate_));
+  for (int hm = 0; hm < kNum3OAHarmonics; hm++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      input3OABuf_.getChannelDataToWrite(hm)[i] = noise_[i];
+    }
+  }
+
+  sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), kMaxBufferSize);
+  EXPECT_EQ(sph_rend.getDeadlineStats().numCalls, 0u);
+
+  sph_rend.setDeadlineMonitoring(kTestSampleRate_);
+  const int kBlockSizes[] = {64, 256, 1024};
+  HeapGuard guard;
+  for (int bufferLength : kBlockSizes) {
+    sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), bufferLength);
+  }
+  EXPECT_EQ(guard.numAllocations(), 0u);
+
+  const DeadlineStats stats = sph_rend.getDeadlineStats();
+  EXPECT_EQ(stats.numCalls, 3u);
+  EXPECT_GT(stats.worstNs, 0u);
+  EXPECT_GT(stats.worstLoad, 0.0);
+  EXPECT_GE(stats.worstLoad, stats.getMeanLoad());
+  EXPECT_EQ(stats.getCallsAbove(0.0), 3u);
+
+  sph_rend.resetDeadlineStats();
+  sph_rend.process(input3OABuf_.getDataReadOnly(), binauralOutBuffer_.getData(), 128);
+  EXPECT_EQ(sph_rend.getDeadlineStats().numCalls, 1u);
+}
+
+// The process paths of the renderer must neither allocate nor lock, see test_RealtimeSafety.cpp in
+// the dsp tests. ctest runs these once per tier with TBE_DSP_TIER.
+class RealtimeSafety : public AmbiSphericalConvolutionTest {};
+
+TEST_F(RealtimeSafety, AmbiSphericalConvolution) {
+  const int kEdgeBlockSizes[] = {
+      1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 127, 128, 129, 255, 256, 257, 1023,
+      static_cast<int>(kMaxBufferSize)};
+  AmbiSphericalConvolution sph_rend(
+      kMaxBufferSize, get3OAAmbisonicImpulseResponse(kTestSampleRate_));
+  AudioBufferList headLocked(kMaxBufferSize, kStereoNumChannels);
+  for (int hm = 0; hm < kNum3OAHarmonics; hm++) {
+    for (int i = 0; i < kMaxBufferSize; i++) {
+      input3OABuf_.getChannelDataToWrite(hm)[i] = noise_[i];
+    }
+  }
+  for (int i = 0; i < kMaxBufferSize; i++) {
+    headLocked.getChannelDataToWrite(0)[i] = noise_[i];
+    headLocked.getChannelDataToWrite(1)[i] = -noise_[i];
+  }
+  const float** in = input3OABuf_.getDataReadOnly();
+  float** out = binauralOutBuffer_.getData();
+
+  for (int pass = 0; pass < 3; pass++) {
+    // With the instrumentation on, and with silent upper orders so harmonics get skipped
+    sph_rend.setProfilingEnabled(pass > 0);
+    sph_rend.setDeadlineMonitoring(pass > 0 ? kTestSampleRate_ : 0.f);
+    sph_rend.setDenormalProtection(pass != 1);
+    if (pass == 2) {
+      for (int hm = 4; hm < kNum3OAHarmonics; hm++) {
+        memset(input3OABuf_.getChannelDataToWrite(hm), 0, kMaxBufferSize * sizeof(float));
+      }
+    }
+
+    for (int n : kEdgeBlockSizes) {
+      const ConstAudioBufferView inView = input3OABuf_.view().samples(0, n);
+      const AudioBufferView outView = binauralOutBuffer_.view().samples(0, n);
+      const ConstAudioBufferView headLockedView = headLocked.view().samples(0, n);
+      EXPECT_REALTIME_SAFE(sph_rend.process(in, out, n));
+      EXPECT_REALTIME_SAFE(sph_rend.process(in, out, n, headLocked.getDataReadOnly(), 0.5f));
+      EXPECT_REALTIME_SAFE(sph_rend.process(inView, outView));
+      EXPECT_REALTIME_SAFE(sph_rend.process(inView, outView, headLockedView, 0.5f));
+      EXPECT_REALTIME_SAFE(sph_rend.getStats());
+      EXPECT_REALTIME_SAFE(sph_rend.getDeadlineStats());
+    }
+  }
+}
 } // namespace TBE